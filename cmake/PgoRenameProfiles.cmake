@@ -0,0 +1,27 @@
+# SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+# SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+#
+# Script mode helper for the GCC PGO workflow of vsc_add_verilated_bench(). GCC names
+# .gcda files after the absolute path of the object they belong to, so profiles from the
+# instrumented build are copied to the names the optimized build looks up.
+#
+# cmake -DPROFILE_DIR=<dir> -DOUTPUT_DIR=<dir> -DREPLACE=<from>|<to>[|<from>|<to>...]
+#       -P PgoRenameProfiles.cmake
+string(REPLACE "|" ";" replacements "${REPLACE}")
+file(REMOVE_RECURSE "${OUTPUT_DIR}")
+file(MAKE_DIRECTORY "${OUTPUT_DIR}")
+file(GLOB profiles "${PROFILE_DIR}/*.gcda")
+if (NOT profiles)
+    message(FATAL_ERROR "no profiles in ${PROFILE_DIR}, did the training run fail?")
+endif()
+foreach(profile ${profiles})
+    get_filename_component(name "${profile}" NAME)
+    set(remaining ${replacements})
+    while(remaining)
+        list(GET remaining 0 from)
+        list(GET remaining 1 to)
+        list(REMOVE_AT remaining 0 1)
+        string(REPLACE "${from}" "${to}" name "${name}")
+    endwhile()
+    configure_file("${profile}" "${OUTPUT_DIR}/${name}" COPYONLY)
+endforeach()
@@ -2,6 +2,9 @@
 # SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
 include_guard(GLOBAL)
 
+# location of the helper scripts, for use from inside functions
+set(VSC_CMAKE_DIR "${CMAKE_CURRENT_LIST_DIR}" CACHE INTERNAL "")
+
 function(configure_target_with_defaults target)
     target_include_directories("${target}" PUBLIC ${PROJ_INCLUDE_DIR})
     target_compile_features("${target}" PUBLIC ${PROJ_CXX_VERSION})
@@ -11,3 +14,333 @@ function(configure_target_with_defaults target)
         CXX_EXTENSIONS FALSE
     )
 endfunction()
+
+# Verilate RTL into a model library and build an executable bench against VSC::core,
+# or VSC::gfx as well if the bench opens display windows.
+#
+# vsc_add_verilated_bench(<target>
+#     SOURCES <bench .cpp files>
+#     VERILOG_SOURCES <rtl files>
+#     [TOP_MODULE <name>] [PREFIX <class name>]
+#     [THREADS <n>]                 # verilator --threads, default single threaded
+#     [OUTPUT_SPLIT <n>]            # --output-split/--output-split-cfuncs, default 20000
+#     [OPT_FAST <flags>]            # compile flags of the hot model code, default -O3
+#     [OPT_SLOW <flags>]            # compile flags of the run-once code, default -O1
+#     [OPT_GLOBAL <flags>]          # compile flags of the verilated runtime, default -O2
+#     [INCLUDE_DIRS <dirs>] [VERILATOR_ARGS <args>]
+#     [SAVABLE] [TRACE] [COVERAGE] [GFX]
+#     [EXPLICIT_INSTANTIATION [INSTANTIATE <bench template args>...]]
+#     [PRECOMPILE_HEADERS]
+#     [PGO PGO_TRAINING_ARGS <args>])
+#
+# The model is compiled into its own <target>_model static library so the bench's
+# warning flags do not apply to generated code.
+#
+# EXPLICIT_INSTANTIATION generates VscBenchInstances.h/.cpp under <target>.dir: the
+# header declares the bench templates extern and is included into every bench source,
+# the source file instantiates them once (see VSC/Instantiation.h). INSTANTIATE lists
+# the template arguments of each bench type, e.g. "Vtop, vsc::TracePolicy"; the
+# default is the plain model bench. PRECOMPILE_HEADERS precompiles the Verilator,
+# model and VSC bench headers (and the generated header) for the bench sources.
+#
+# With PGO the bench is built in up to three stages, each run with PGO_TRAINING_ARGS:
+#   1. <target>_pgo_vlt: verilated with --prof-pgo (only with THREADS > 1), its run
+#      records the thread schedule feedback into profile.vlt
+#   2. <target>_pgo_gen: verilated with profile.vlt and compiled with the compiler's
+#      profile instrumentation, its run records the compiler profile
+#   3. <target>: the code of stage 2 compiled using the compiler profile
+# The <target>_pgo_train target runs the training; building <target> triggers it, and
+# it reruns whenever the instrumented build changes. The
+# bench should pass its command line to VerilatedContext::commandArgs() so the profile
+# file argument reaches the model. Supported compilers are GCC and Clang.
+function(vsc_add_verilated_bench target)
+    set(list_args SOURCES VERILOG_SOURCES INCLUDE_DIRS VERILATOR_ARGS
+                  OPT_FAST OPT_SLOW OPT_GLOBAL PGO_TRAINING_ARGS)
+    cmake_parse_arguments(PARSE_ARGV 1 arg
+        "SAVABLE;TRACE;COVERAGE;GFX;PGO;EXPLICIT_INSTANTIATION;PRECOMPILE_HEADERS"
+        "TOP_MODULE;PREFIX;THREADS;OUTPUT_SPLIT"
+        "${list_args};INSTANTIATE")
+    if (NOT arg_VERILOG_SOURCES)
+        message(FATAL_ERROR "vsc_add_verilated_bench(${target}): no VERILOG_SOURCES")
+    endif()
+    if (NOT COMMAND verilate)
+        find_package(verilator REQUIRED HINTS $ENV{VERILATOR_ROOT} ${VERILATOR_ROOT})
+    endif()
+
+    # tuned defaults, overridable per bench
+    if (NOT arg_OUTPUT_SPLIT)
+        set(arg_OUTPUT_SPLIT 20000)
+    endif()
+    if (NOT arg_OPT_FAST)
+        set(arg_OPT_FAST -O3)
+    endif()
+    if (NOT arg_OPT_SLOW)
+        set(arg_OPT_SLOW -O1)
+    endif()
+    if (NOT arg_OPT_GLOBAL)
+        set(arg_OPT_GLOBAL -O2)
+    endif()
+    if (arg_PRECOMPILE_HEADERS AND CMAKE_VERSION VERSION_LESS 3.16)
+        message(FATAL_ERROR "vsc_add_verilated_bench(${target}): PRECOMPILE_HEADERS "
+                            "requires CMake 3.16")
+    endif()
+
+    # verilator names the model class after the top module, or the first source file
+    if (arg_PREFIX)
+        set(model_prefix ${arg_PREFIX})
+    elseif (arg_TOP_MODULE)
+        set(model_prefix V${arg_TOP_MODULE})
+    else()
+        list(GET arg_VERILOG_SOURCES 0 first_source)
+        get_filename_component(model_prefix "${first_source}" NAME_WE)
+        set(model_prefix V${model_prefix})
+    endif()
+
+    set(bench_name ${target}) # stages keep their generated code under <target>.dir
+    set(instance_dir "${CMAKE_CURRENT_BINARY_DIR}/${target}.dir/instances")
+    if (arg_EXPLICIT_INSTANTIATION)
+        _vsc_generate_bench_instances()
+    endif()
+    if (NOT bench_kind)
+        set(bench_kind EXECUTABLE)
+    endif()
+    set(vsc_libs VSC::core)
+    if (arg_GFX)
+        list(APPEND vsc_libs VSC::gfx)
+    endif()
+    if (NOT arg_PGO)
+        _vsc_add_bench_stage(${target} verilated "" "" "" "")
+        return()
+    endif()
+    if (bench_kind STREQUAL "MODULE")
+        message(FATAL_ERROR "vsc_add_model_plugin(${target}): PGO is only supported for "
+                            "bench executables")
+    endif()
+
+    set(pgo_dir "${CMAKE_CURRENT_BINARY_DIR}/${target}.dir/pgo")
+    set(profile_vlt "${pgo_dir}/profile.vlt")
+    set(run_args ${arg_PGO_TRAINING_ARGS} "+verilator+prof+vlt+file+${profile_vlt}")
+    file(MAKE_DIRECTORY "${pgo_dir}")
+    # verilate() runs verilator at configure time, so the profile has to exist before
+    # the first training run replaces it
+    if (NOT EXISTS "${profile_vlt}")
+        file(WRITE "${profile_vlt}" "`verilator_config\n")
+    endif()
+
+    # stage 1: thread schedule feedback for multithreaded models
+    if (arg_THREADS AND arg_THREADS GREATER 1)
+        _vsc_add_bench_stage(${target}_pgo_vlt pgo_vlt "--prof-pgo" "" "" "")
+        add_custom_command(OUTPUT "${pgo_dir}/vlt.stamp"
+            COMMAND $<TARGET_FILE:${target}_pgo_vlt> ${run_args}
+            COMMAND ${CMAKE_COMMAND} -E touch "${pgo_dir}/vlt.stamp"
+            BYPRODUCTS "${profile_vlt}"
+            DEPENDS ${target}_pgo_vlt
+            WORKING_DIRECTORY "${pgo_dir}"
+            COMMENT "Collecting Verilator thread profile for ${target}"
+            VERBATIM)
+        add_custom_target(${target}_pgo_vlt_train DEPENDS "${pgo_dir}/vlt.stamp")
+    endif()
+
+    # stage 2: compiler profile, built from the same verilated code as the final stage
+    if (CMAKE_CXX_COMPILER_ID STREQUAL "GNU")
+        set(gen_flags "-fprofile-generate=${pgo_dir}/gcda" -fprofile-update=atomic)
+        set(use_flags "-fprofile-use=${pgo_dir}/use" -fprofile-partial-training
+                      -Wno-missing-profile)
+        # GCC names its profiles after the object paths, which differ between the
+        # generate and use builds, so the files are renamed to the final stage's paths
+        set(collect_commands
+            COMMAND ${CMAKE_COMMAND} -DPROFILE_DIR=${pgo_dir}/gcda
+                    -DOUTPUT_DIR=${pgo_dir}/use
+                    "-DREPLACE=${target}_pgo_gen|${target}"
+                    -P "${VSC_CMAKE_DIR}/PgoRenameProfiles.cmake")
+    elseif (CMAKE_CXX_COMPILER_ID MATCHES "Clang")
+        get_filename_component(compiler_dir "${CMAKE_CXX_COMPILER}" DIRECTORY)
+        find_program(LLVM_PROFDATA llvm-profdata HINTS "${compiler_dir}" REQUIRED)
+        set(gen_flags "-fprofile-instr-generate=${pgo_dir}/bench.profraw")
+        set(use_flags "-fprofile-instr-use=${pgo_dir}/bench.profdata"
+                      -Wno-profile-instr-unprofiled)
+        set(collect_commands
+            COMMAND ${LLVM_PROFDATA} merge -o "${pgo_dir}/bench.profdata"
+                    "${pgo_dir}/bench.profraw")
+    else()
+        message(FATAL_ERROR "vsc_add_verilated_bench(${target}): PGO is not supported "
+                            "with ${CMAKE_CXX_COMPILER_ID}")
+    endif()
+    _vsc_add_bench_stage(${target}_pgo_gen pgo_gen "" "${profile_vlt}" "${gen_flags}"
+                         "${gen_flags}")
+    if (TARGET ${target}_pgo_vlt_train)
+        add_dependencies(${target}_pgo_gen_model ${target}_pgo_vlt_train)
+    endif()
+    add_custom_command(OUTPUT "${pgo_dir}/gen.stamp"
+        COMMAND ${CMAKE_COMMAND} -E remove_directory "${pgo_dir}/gcda"
+        COMMAND ${CMAKE_COMMAND} -E remove -f "${pgo_dir}/bench.profraw"
+        COMMAND $<TARGET_FILE:${target}_pgo_gen> ${arg_PGO_TRAINING_ARGS}
+        ${collect_commands}
+        COMMAND ${CMAKE_COMMAND} -E touch "${pgo_dir}/gen.stamp"
+        DEPENDS ${target}_pgo_gen
+        WORKING_DIRECTORY "${pgo_dir}"
+        COMMENT "Collecting compiler profile for ${target}"
+        VERBATIM)
+    add_custom_target(${target}_pgo_train DEPENDS "${pgo_dir}/gen.stamp")
+
+    # stage 3: the optimized bench. GCC matches profiles by source location, so the
+    # generated code of stage 2 is compiled again instead of verilating a copy.
+    set(gen_model ${target}_pgo_gen_model)
+    set(model ${target}_model)
+    get_target_property(model_sources ${gen_model} SOURCES)
+    add_library(${model} STATIC ${model_sources})
+    foreach(property INCLUDE_DIRECTORIES INTERFACE_INCLUDE_DIRECTORIES
+                     COMPILE_DEFINITIONS INTERFACE_COMPILE_DEFINITIONS
+                     COMPILE_FEATURES INTERFACE_COMPILE_FEATURES
+                     LINK_LIBRARIES INTERFACE_LINK_LIBRARIES)
+        get_target_property(value ${gen_model} ${property})
+        if (value)
+            set_property(TARGET ${model} PROPERTY ${property} ${value})
+        endif()
+    endforeach()
+    target_compile_options(${model} PRIVATE ${use_flags})
+    add_dependencies(${model} ${target}_pgo_train)
+
+    add_executable(${target} ${arg_SOURCES})
+    target_compile_features(${target} PRIVATE cxx_std_20)
+    target_compile_options(${target} PRIVATE ${use_flags})
+    target_link_libraries(${target} PRIVATE ${model} ${vsc_libs})
+    _vsc_configure_bench_compile(${target})
+    add_dependencies(${target} ${target}_pgo_train)
+endfunction()
+
+# Verilate RTL into a model plugin, a shared object <target>.so that the generic vsc-run
+# tool (or any host using PluginLibrary) loads at runtime. SOURCES must contain the
+# adapter defined with VSC_DEFINE_MODEL_PLUGIN, see VSC/plugin/ModelPlugin.h. Takes the
+# arguments of vsc_add_verilated_bench() except PGO.
+#
+# Rebuilding after an RTL change only relinks the plugin; the runner stays as it is.
+function(vsc_add_model_plugin target)
+    set(bench_kind MODULE)
+    vsc_add_verilated_bench(${target} ${ARGN})
+endfunction()
+
+# Build one verilated model library and bench executable from the arguments parsed by
+# vsc_add_verilated_bench(), with per-stage additions for the PGO workflow.
+function(_vsc_add_bench_stage target directory extra_verilator_args extra_verilog_sources
+                              compile_flags link_flags)
+    set(verilator_args
+        -O3 --x-assign fast --x-initial fast
+        --output-split ${arg_OUTPUT_SPLIT}
+        --output-split-cfuncs ${arg_OUTPUT_SPLIT})
+    if (arg_SAVABLE)
+        list(APPEND verilator_args --savable)
+    endif()
+    list(APPEND verilator_args ${arg_VERILATOR_ARGS} ${extra_verilator_args})
+
+    set(verilate_opts "")
+    foreach(flag TRACE COVERAGE)
+        if (arg_${flag})
+            list(APPEND verilate_opts ${flag})
+        endif()
+    endforeach()
+    foreach(value TOP_MODULE PREFIX THREADS)
+        if (arg_${value})
+            list(APPEND verilate_opts ${value} ${arg_${value}})
+        endif()
+    endforeach()
+    if (arg_INCLUDE_DIRS)
+        list(APPEND verilate_opts INCLUDE_DIRS ${arg_INCLUDE_DIRS})
+    endif()
+
+    set(model "${target}_model")
+    add_library(${model} STATIC)
+    target_compile_features(${model} PUBLIC cxx_std_20)
+    target_compile_options(${model} PRIVATE ${compile_flags})
+    verilate(${model}
+        SOURCES ${arg_VERILOG_SOURCES} ${extra_verilog_sources}
+        ${verilate_opts}
+        DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}/${bench_name}.dir/${directory}"
+        VERILATOR_ARGS ${verilator_args}
+        OPT_FAST ${arg_OPT_FAST}
+        OPT_SLOW ${arg_OPT_SLOW}
+        OPT_GLOBAL ${arg_OPT_GLOBAL})
+
+    if (bench_kind STREQUAL "MODULE")
+        # only the plugin entry point is exported, which also lets the compiler treat
+        # every other symbol as local
+        set_target_properties(${model} PROPERTIES POSITION_INDEPENDENT_CODE ON)
+        add_library(${target} MODULE ${arg_SOURCES})
+        set_target_properties(${target} PROPERTIES
+            PREFIX ""
+            CXX_VISIBILITY_PRESET hidden
+            VISIBILITY_INLINES_HIDDEN ON)
+    else()
+        add_executable(${target} ${arg_SOURCES})
+    endif()
+    target_compile_features(${target} PRIVATE cxx_std_20)
+    target_compile_options(${target} PRIVATE ${compile_flags})
+    target_link_options(${target} PRIVATE ${link_flags})
+    target_link_libraries(${target} PRIVATE ${model} ${vsc_libs})
+    _vsc_configure_bench_compile(${target})
+endfunction()
+
+# Write the explicit instantiation header and source of the bench being added. Files are
+# only rewritten when their content changes, so reconfiguring does not rebuild them.
+function(_vsc_generate_bench_instances)
+    set(bench_types ${arg_INSTANTIATE})
+    if (NOT bench_types)
+        set(bench_types ${model_prefix})
+    endif()
+
+    set(header "// Generated by vsc_add_verilated_bench(${bench_name}), do not edit.\n")
+    string(APPEND header "#ifndef VSC_BENCH_INSTANCES_H_\n")
+    string(APPEND header "#define VSC_BENCH_INSTANCES_H_\n\n")
+    string(APPEND header "#include <${model_prefix}.h>\n\n")
+    string(APPEND header "#include \"VSC/BenchPolicy.h\"\n")
+    string(APPEND header "#include \"VSC/Instantiation.h\"\n")
+    if (arg_SAVABLE)
+        string(APPEND header "#include \"VSC/sim/Checkpoint.h\"\n")
+    endif()
+    string(APPEND header "\n")
+    set(source "// Generated by vsc_add_verilated_bench(${bench_name}), do not edit.\n")
+    string(APPEND source "#include \"VscBenchInstances.h\"\n\n")
+    foreach(bench_type IN LISTS bench_types)
+        string(APPEND header "VSC_EXTERN_VERILATOR_BENCH(${bench_type});\n")
+        string(APPEND source "VSC_INSTANTIATE_VERILATOR_BENCH(${bench_type});\n")
+        if (arg_SAVABLE)
+            string(APPEND header "VSC_EXTERN_CHECKPOINT(${bench_type});\n")
+            string(APPEND source "VSC_INSTANTIATE_CHECKPOINT(${bench_type});\n")
+        endif()
+    endforeach()
+    string(APPEND header "\n#endif /* VSC_BENCH_INSTANCES_H_ */\n")
+
+    _vsc_write_if_changed("${instance_dir}/VscBenchInstances.h" "${header}")
+    _vsc_write_if_changed("${instance_dir}/VscBenchInstances.cpp" "${source}")
+endfunction()
+
+function(_vsc_write_if_changed path content)
+    if (EXISTS "${path}")
+        file(READ "${path}" current)
+        if (current STREQUAL content)
+            return()
+        endif()
+    endif()
+    file(WRITE "${path}" "${content}")
+endfunction()
+
+# Add the explicit instantiations and precompiled headers requested for the bench being
+# added to one of its bench targets.
+function(_vsc_configure_bench_compile target)
+    set(instance_header "${instance_dir}/VscBenchInstances.h")
+    if (arg_EXPLICIT_INSTANTIATION)
+        target_sources(${target} PRIVATE "${instance_dir}/VscBenchInstances.cpp")
+        target_include_directories(${target} PRIVATE "${instance_dir}")
+    endif()
+    if (arg_PRECOMPILE_HEADERS)
+        # precompiled headers are force-included, which covers the extern declarations
+        set(headers <verilated.h> <${model_prefix}.h> <VSC/VerilatorBench.h>
+                    <VSC/BenchPolicy.h>)
+        if (arg_EXPLICIT_INSTANTIATION)
+            list(APPEND headers "${instance_header}")
+        endif()
+        target_precompile_headers(${target} PRIVATE ${headers})
+    elseif (arg_EXPLICIT_INSTANTIATION)
+        target_compile_options(${target} PRIVATE "SHELL:-include \"${instance_header}\"")
+    endif()
+endfunction()
@@ -0,0 +1,189 @@
+/** @file
+ * Instrumentation policies for VerilatorBench.
+ *
+ * A policy only costs anything when it is part of the bench type, e.g.
+ *   using DebugBench = VerilatorBench<Vtop, TracePolicy, PerfPolicy, CycleWatchdog>;
+ *   using FastBench = VerilatorBench<Vtop>;
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_BENCH_POLICY_H_
+#define VSC_BENCH_POLICY_H_
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include "VSC/sim/Checkpoint.h"
+#include "VSC/sim/LiveStats.h"
+#include "VSC/util/BenchPhase.h"
+#include "VSC/util/PerfCounters.h"
+#include "VSC/util/Trace.h"
+
+namespace vsc {
+
+/**
+ * Records every bench phase as a trace span while tracing is started, see Trace.h.
+ * Eval phases use the "model" category and the edge handlers "bench".
+ */
+class TracePolicy {
+private:
+    std::array<std::int64_t, benchPhaseCount> startNs{};
+
+public:
+    void beginPhase(BenchPhase phase) {
+        startNs[static_cast<std::size_t>(phase)] =
+            isTracing() ? internal::traceClockNs() : -1;
+    }
+    void endPhase(BenchPhase phase) {
+        const std::int64_t start = startNs[static_cast<std::size_t>(phase)];
+        if (start >= 0) {
+            internal::recordTraceEvent({benchPhaseName(phase),
+                                        isEvalPhase(phase) ? "model" : "bench", start,
+                                        internal::traceClockNs() - start, 'X', 0.0});
+        }
+    }
+};
+
+/**
+ * Measures hardware performance counters per bench phase, see PhaseCounters.
+ *
+ * The counters are opened on the first cycle, so they belong to the thread that drives
+ * the bench. Set sampleEvery before the first cycle to measure only every Nth cycle.
+ */
+class PerfPolicy {
+private:
+    std::unique_ptr<PhaseCounters> counters;
+    bool measuring = false;
+
+public:
+    std::uint64_t sampleEvery = 1;
+
+    template <typename Model> void beforeCycle(Model*, unsigned long) {
+        if (!counters) {
+            counters = std::make_unique<PhaseCounters>(sampleEvery);
+        }
+        measuring = counters->beginCycle();
+    }
+    void beginPhase(BenchPhase) {
+        if (measuring) {
+            counters->enterPhase();
+        }
+    }
+    void endPhase(BenchPhase phase) {
+        if (measuring) {
+            counters->leavePhase(phase);
+        }
+    }
+    PhaseCounterReport report() const {
+        return counters ? counters->report() : PhaseCounterReport{};
+    }
+};
+
+/**
+ * Publishes the bench's cycle count to a live stats page, see LiveStatsPublisher.
+ *
+ * Nothing is published until open() is called. Transactions and errors are counted
+ * through publisher().
+ */
+class LiveStatsPolicy {
+private:
+    std::unique_ptr<LiveStatsPublisher> stats;
+
+public:
+    void open(const std::string& name, std::uint64_t intervalCycles = 65536) {
+        stats = std::make_unique<LiveStatsPublisher>(name, intervalCycles);
+    }
+    LiveStatsPublisher& publisher() { return *stats; }
+
+    template <typename Model> void afterCycle(Model*, unsigned long cycles) {
+        if (stats) {
+            stats->maybePublish(cycles);
+        }
+    }
+    // publish the restart right away, which also restarts the publish schedule
+    template <typename Model> void onReset(Model*) {
+        if (stats) {
+            stats->publish(0);
+        }
+    }
+};
+
+/**
+ * Aborts runaway simulations by throwing std::runtime_error
+ *
+ * maxCycles bounds the cycles since reset. timeoutCycles bounds the cycles between
+ * kick() calls, which the bench should issue whenever the design makes progress (e.g.
+ * a transaction completes). Zero disables either limit. After a checkpoint restore to an
+ * earlier cycle, the progress timeout counts from the restored cycle.
+ */
+class CycleWatchdog {
+private:
+    unsigned long lastKick = 0;
+    unsigned long current = 0;
+
+public:
+    std::uint64_t maxCycles = 0;
+    std::uint64_t timeoutCycles = 0;
+
+    void kick() { lastKick = current; }
+
+    template <typename Model> void afterCycle(Model*, unsigned long cycles) {
+        current = cycles;
+        if (cycles < lastKick) {
+            lastKick = cycles; // restored to an earlier checkpoint, which is no reset
+        }
+        if (maxCycles != 0 && cycles > maxCycles) {
+            throw std::runtime_error("watchdog: cycle limit of " +
+                                     std::to_string(maxCycles) + " exceeded");
+        }
+        if (timeoutCycles != 0 && cycles - lastKick > timeoutCycles) {
+            throw std::runtime_error("watchdog: no progress for " +
+                                     std::to_string(timeoutCycles) + " cycles at cycle " +
+                                     std::to_string(cycles));
+        }
+    }
+    template <typename Model> void onReset(Model*) {
+        lastKick = 0;
+        current = 0;
+    }
+};
+
+/**
+ * Detects whether a cycle changed any model state by hashing it, see stateHash()
+ *
+ * Useful to stop a run once the design is quiescent. Costs a serialization and hash of
+ * the full design state per cycle, so it belongs in debug benches. Requires a model
+ * verilated with --savable.
+ */
+class StateChangeDetector {
+private:
+    std::uint64_t previous = 0;
+    std::uint64_t unchanged = 0;
+
+public:
+    /**
+     * Get the number of consecutive cycles that left the state unchanged.
+     */
+    std::uint64_t unchangedCycles() const { return unchanged; }
+    bool changed() const { return unchanged == 0; }
+
+    template <typename Model> void afterCycle(Model* model, unsigned long) {
+        static_assert(SavableToplevel<Model>,
+                      "StateChangeDetector needs a model verilated with --savable");
+        const std::uint64_t hash = internal::serializedStateHash(*model);
+        unchanged = hash == previous ? unchanged + 1 : 0;
+        previous = hash;
+    }
+    template <typename Model> void onReset(Model*) {
+        previous = 0;
+        unchanged = 0;
+    }
+};
+
+} // namespace vsc
+
+#endif /* VSC_BENCH_POLICY_H_ */
@@ -0,0 +1,196 @@
+/** @file
+ * This header contains public definitions for the combinational sweep bench.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_COMB_BENCH_H_
+#define VSC_COMB_BENCH_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <verilated.h>
+
+#include "VSC/util/Concept.h"
+#include "VSC/util/Parallel.h"
+
+namespace vsc {
+
+/**
+ * Input vector applier constraint
+ *
+ * A valid function must have the signature void apply(TopModule* m, std::uint64_t vec),
+ * where vec is the index of the input vector to drive onto the model.
+ */
+template <typename ApplyFun, typename TopModule>
+concept VectorApplier = std::invocable<ApplyFun&, TopModule*, std::uint64_t>;
+
+/**
+ * Output column extractor constraint
+ *
+ * A valid function must have the signature R extract(const TopModule* m), returning one
+ * column value for the vector just evaluated.
+ */
+template <typename ExtractFun, typename TopModule>
+concept ColumnExtractor =
+    std::invocable<ExtractFun&, const TopModule*> &&
+    !std::is_void_v<std::invoke_result_t<ExtractFun&, const TopModule*>>;
+
+/**
+ * Storage type of an output column. Bool columns are stored as bytes so that workers can
+ * write neighbouring entries concurrently.
+ */
+template <typename ExtractFun, typename TopModule>
+using ColumnValue = std::conditional_t<
+    std::is_same_v<std::decay_t<std::invoke_result_t<ExtractFun&, const TopModule*>>,
+                   bool>,
+    std::uint8_t, std::decay_t<std::invoke_result_t<ExtractFun&, const TopModule*>>>;
+
+struct SweepOptions {
+    unsigned workers = 0;              // 0 = all cores, one model instance per worker
+    std::uint64_t chunkVectors = 4096; // vectors per scheduling unit
+};
+
+/**
+ * A driver for verilated models that have no clock or reset
+ *
+ * Each evaluation drives one input vector, settles the model with eval() and samples the
+ * outputs. Unlike VerilatorBench there is no cycle concept, which suits combinational
+ * blocks (ALUs, decoders) and small sequential blocks that clock themselves from the
+ * applied inputs.
+ * @tparam TopModule The Model created by verilating the design
+ */
+template <EvaluableModel TopModule> class CombBench {
+public:
+    /**
+     * Direct access to the verilator topmodule
+     */
+    TopModule* topmodule;
+
+    /**
+     * Create the wrapped model, forwarding any arguments to its constructor.
+     */
+    template <typename... ModelArgs>
+        requires std::constructible_from<TopModule, ModelArgs...>
+    explicit CombBench(ModelArgs&&... modelArgs);
+    ~CombBench();
+    /**
+     * Drive one input vector and settle the model.
+     */
+    template <VectorApplier<TopModule> ApplyFun>
+    void evaluate(ApplyFun apply, std::uint64_t vec);
+    /**
+     * Evaluate the vectors [begin, end), sampling the model after each one into
+     * columns, at offset (vec - begin).
+     * @param columns one output iterator (typically a pointer into a column buffer) per
+     *                extractor
+     */
+    template <VectorApplier<TopModule> ApplyFun, typename... Outputs,
+              ColumnExtractor<TopModule>... ExtractFuns>
+    void evaluateRange(std::uint64_t begin, std::uint64_t end, ApplyFun apply,
+                       std::tuple<Outputs...> columns, ExtractFuns... extract);
+
+    // disable copying
+    CombBench(const CombBench<TopModule>& other) = delete;
+    CombBench& operator=(const CombBench<TopModule>& other) = delete;
+};
+
+/**
+ * Evaluate vectors [0, count) on all cores and collect the outputs column-wise.
+ *
+ * Every worker owns a model instance with its own VerilatedContext and evaluates chunks
+ * of consecutive vectors; the column buffers are allocated up front and each vector's
+ * outputs land at its index, so the result does not depend on scheduling. For an
+ * exhaustive sweep pass count = 1 << inputBits and decode the vector index into the
+ * input ports in apply.
+ * @param count number of input vectors
+ * @param apply callable driving input vector vec onto the model
+ * @param options worker count and chunk size
+ * @param extract one callable per output column
+ * @return tuple of one std::vector per extractor, each of length count
+ */
+template <EvaluableModel TopModule, VectorApplier<TopModule> ApplyFun,
+          ColumnExtractor<TopModule>... ExtractFuns>
+std::tuple<std::vector<ColumnValue<ExtractFuns, TopModule>>...>
+sweepInputSpace(std::uint64_t count, ApplyFun apply, const SweepOptions& options,
+                ExtractFuns... extract);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+template <EvaluableModel TopModule>
+template <typename... ModelArgs>
+    requires std::constructible_from<TopModule, ModelArgs...>
+CombBench<TopModule>::CombBench(ModelArgs&&... modelArgs)
+    : topmodule(new TopModule(std::forward<ModelArgs>(modelArgs)...)) {
+}
+
+template <EvaluableModel TopModule> CombBench<TopModule>::~CombBench() {
+    delete topmodule;
+}
+
+template <EvaluableModel TopModule>
+template <VectorApplier<TopModule> ApplyFun>
+void CombBench<TopModule>::evaluate(ApplyFun apply, std::uint64_t vec) {
+    apply(topmodule, vec);
+    topmodule->eval();
+}
+
+template <EvaluableModel TopModule>
+template <VectorApplier<TopModule> ApplyFun, typename... Outputs,
+          ColumnExtractor<TopModule>... ExtractFuns>
+void CombBench<TopModule>::evaluateRange(std::uint64_t begin, std::uint64_t end,
+                                         ApplyFun apply, std::tuple<Outputs...> columns,
+                                         ExtractFuns... extract) {
+    static_assert(sizeof...(Outputs) == sizeof...(ExtractFuns),
+                  "one output column is required per extractor");
+    const TopModule* model = topmodule;
+    for (std::uint64_t vec = begin; vec < end; ++vec) {
+        apply(topmodule, vec);
+        topmodule->eval();
+        std::apply([&](auto&... out) { ((*out++ = extract(model)), ...); }, columns);
+    }
+}
+
+template <EvaluableModel TopModule, VectorApplier<TopModule> ApplyFun,
+          ColumnExtractor<TopModule>... ExtractFuns>
+std::tuple<std::vector<ColumnValue<ExtractFuns, TopModule>>...>
+sweepInputSpace(std::uint64_t count, ApplyFun apply, const SweepOptions& options,
+                ExtractFuns... extract) {
+    std::tuple<std::vector<ColumnValue<ExtractFuns, TopModule>>...> columns;
+    std::apply([&](auto&... column) { (column.resize(count), ...); }, columns);
+
+    struct Worker {
+        VerilatedContext context;
+        CombBench<TopModule> bench{&context};
+    };
+    const unsigned workerCount =
+        options.workers == 0 ? defaultWorkerCount() : options.workers;
+    std::vector<std::unique_ptr<Worker>> workers(workerCount);
+
+    const std::uint64_t chunk = std::max<std::uint64_t>(options.chunkVectors, 1);
+    const std::uint64_t chunks = (count + chunk - 1) / chunk;
+    parallelFor(chunks, workerCount, [&](std::size_t index, unsigned self) {
+        if (!workers[self]) {
+            workers[self] = std::make_unique<Worker>();
+        }
+        const std::uint64_t begin = index * chunk;
+        const std::uint64_t end = std::min(begin + chunk, count);
+        auto outputs = std::apply(
+            [&](auto&... column) { return std::make_tuple(column.data() + begin...); },
+            columns);
+        workers[self]->bench.evaluateRange(begin, end, apply, outputs, extract...);
+    });
+    return columns;
+}
+
+} // namespace vsc
+
+#endif /* VSC_COMB_BENCH_H_ */
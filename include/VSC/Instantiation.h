@@ -0,0 +1,61 @@
+/** @file
+ * Explicit instantiation of bench templates in one translation unit per model.
+ *
+ * Every translation unit that uses a VerilatorBench otherwise instantiates and compiles
+ * the bench's non-template members (destructor, reset() with its policy hooks) and, for
+ * savable models, the checkpoint capture/restore again. Declare the instantiations in a
+ * header seen by all bench sources, and define them in exactly one source file:
+ *
+ *   // VtopBench.h
+ *   VSC_EXTERN_VERILATOR_BENCH(Vtop, vsc::TracePolicy);
+ *   // VtopBench.cpp
+ *   VSC_INSTANTIATE_VERILATOR_BENCH(Vtop, vsc::TracePolicy);
+ *
+ * vsc_add_verilated_bench(... EXPLICIT_INSTANTIATION) generates both files. The macro
+ * arguments are the bench's template arguments.
+ *
+ * Member templates are not covered: the constructor and advanceCycle() are still
+ * compiled in every source that calls them. advanceCycle() in particular is
+ * instantiated per edge handler type and must stay inlinable into the cycle loop. Most
+ * of the saving therefore comes from the checkpoint code, the bench members themselves
+ * are small.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_INSTANTIATION_H_
+#define VSC_INSTANTIATION_H_
+
+#include "VSC/VerilatorBench.h"
+
+/**
+ * Declare that VerilatorBench<...> is instantiated in another translation unit.
+ */
+#define VSC_EXTERN_VERILATOR_BENCH(...)                                                  \
+    extern template class ::vsc::VerilatorBench<__VA_ARGS__>
+/**
+ * Instantiate VerilatorBench<...>; use in exactly one translation unit.
+ */
+#define VSC_INSTANTIATE_VERILATOR_BENCH(...)                                             \
+    template class ::vsc::VerilatorBench<__VA_ARGS__>
+
+/**
+ * Declare that ModelCheckpoint::capture/restore for VerilatorBench<...> are instantiated
+ * in another translation unit. Requires VSC/sim/Checkpoint.h.
+ */
+#define VSC_EXTERN_CHECKPOINT(...)                                                       \
+    extern template void ::vsc::ModelCheckpoint::capture(                                \
+        ::vsc::VerilatorBench<__VA_ARGS__>& bench);                                      \
+    extern template void ::vsc::ModelCheckpoint::restore(                                \
+        ::vsc::VerilatorBench<__VA_ARGS__>& bench) const
+/**
+ * Instantiate ModelCheckpoint::capture/restore for VerilatorBench<...>; use in exactly
+ * one translation unit.
+ */
+#define VSC_INSTANTIATE_CHECKPOINT(...)                                                  \
+    template void ::vsc::ModelCheckpoint::capture(                                       \
+        ::vsc::VerilatorBench<__VA_ARGS__>& bench);                                      \
+    template void ::vsc::ModelCheckpoint::restore(                                       \
+        ::vsc::VerilatorBench<__VA_ARGS__>& bench) const
+
+#endif /* VSC_INSTANTIATION_H_ */
@@ -7,11 +7,20 @@
 #ifndef VSC_VERILATOR_BENCH_H_
 #define VSC_VERILATOR_BENCH_H_
 
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
 #include "VSC/internal/SetMacros.h"
+#include "VSC/util/BenchPhase.h"
 #include "VSC/util/Concept.h"
 
 namespace vsc {
 
+class ModelCheckpoint;
+
 /**
  * A generic testbench driver class for wrapping verilated testbenches
  *
@@ -24,29 +33,63 @@ namespace vsc {
  *   - rst (scalar) - Global reset input
  * This implies that the simulation testbench must be written in a cycle-driven style
  * instead of a timing-driven style.
+ *
+ * Instrumentation (tracing, counters, stats, watchdogs, ...) is added through policy
+ * types, see BenchPolicy.h. Each policy implements any subset of these hooks, which are
+ * called in policy order:
+ *   - beforeCycle(TopModule* model, unsigned long cycle)
+ *   - beginPhase(BenchPhase phase) / endPhase(BenchPhase phase)
+ *   - afterCycle(TopModule* model, unsigned long cycles)
+ *   - onReset(TopModule* model)
+ * Hooks a policy does not implement, and a bench without policies, compile to nothing.
  * @tparam TopModule The Model created by verilating the rtl and testbench files for the
  *                   given design
+ * @tparam Policies Instrumentation policies, default constructed with the bench
  */
-template <VerilatedToplevel TopModule> class VerilatorBench {
+template <VerilatedToplevel TopModule, BenchPolicy... Policies> class VerilatorBench {
 private:
     unsigned long cycles;
+    [[no_unique_address]] std::tuple<Policies...> policies; // empty without policies
+
+    friend class ModelCheckpoint; // restores the cycle count
+
+    template <typename Visitor> void forEachPolicy(Visitor visit) {
+        std::apply([&](auto&... policy) { (visit(policy), ...); }, policies);
+    }
+    template <BenchPhase phase> void beginPhase();
+    template <BenchPhase phase> void endPhase();
 
 public:
+    struct NoOpHandler {
+        void operator()(TopModule* model) const { VSC_UNUSED__(model); }
+    };
     /**
      * Used to as an alias to the no-op function for various edge handler callbacks
+     *
+     * A named type rather than a lambda, which GCC rejects in extern template classes.
      */
-    static auto noOpHandler = [](TopModule* model) { VSC_UNUSED__(model); };
+    static constexpr NoOpHandler noOpHandler{};
     /**
      * Direct access to the verilator topmodule
      */
     TopModule* topmodule;
 
-    VerilatorBench();
+    /**
+     * Create the wrapped model, forwarding any arguments to its constructor. Pass a
+     * dedicated VerilatedContext* when several benches run on different threads.
+     */
+    template <typename... ModelArgs>
+        requires std::constructible_from<TopModule, ModelArgs...>
+    explicit VerilatorBench(ModelArgs&&... modelArgs);
     ~VerilatorBench();
     /**
      * Get the number of cycles since the last reset event.
      */
     unsigned long getCycles() { return cycles; }
+    /**
+     * Access an instrumentation policy, e.g. to configure it or read its results.
+     */
+    template <typename Policy> Policy& policy() { return std::get<Policy>(policies); }
     /**
      * Reset the simulation model.
      */
@@ -58,64 +101,117 @@ public:
      * @param handleClkFalling Callback to execute after the clk falling edge has been
      *                         evaluated.
      */
-    template <ClkEdgeHandler<TopModule> RiseEdgeHandler,
-              ClkEdgeHandler<TopModule> FallEdgeHandler>
+    template <ClkEdgeHandler<TopModule> RiseEdgeHandler = decltype(noOpHandler),
+              ClkEdgeHandler<TopModule> FallEdgeHandler = decltype(noOpHandler)>
     void advanceCycle(RiseEdgeHandler handleClkRising = noOpHandler,
                       FallEdgeHandler handleClkFalling = noOpHandler);
 
     // disable copying
-    VerilatorBench(const VerilatorBench<TopModule>& other) = delete;
-    VerilatorBench& operator=(const VerilatorBench<TopModule>& other) = delete;
+    VerilatorBench(const VerilatorBench& other) = delete;
+    VerilatorBench& operator=(const VerilatorBench& other) = delete;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
 // Template Method Implementations
 ///////////////////////////////////////////////////////////////////////////////
-template <VerilatedToplevel TopModule>
-VerilatorBench<TopModule>::VerilatorBench() : cycles{0}, topmodule(new TopModule) {
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
+template <typename... ModelArgs>
+    requires std::constructible_from<TopModule, ModelArgs...>
+VerilatorBench<TopModule, Policies...>::VerilatorBench(ModelArgs&&... modelArgs)
+    : cycles{0},
+      policies{},
+      topmodule(new TopModule(std::forward<ModelArgs>(modelArgs)...)) {
     // start everything off in a known state
     topmodule->clk = 0;
     topmodule->rst = 0;
 }
 
-template <VerilatedToplevel TopModule> VerilatorBench<TopModule>::~VerilatorBench() {
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
+VerilatorBench<TopModule, Policies...>::~VerilatorBench() {
     delete topmodule;
 }
 
-template <VerilatedToplevel TopModule> void VerilatorBench<TopModule>::reset() {
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
+template <BenchPhase phase>
+void VerilatorBench<TopModule, Policies...>::beginPhase() {
+    forEachPolicy([](auto& policy) {
+        if constexpr (requires { policy.beginPhase(phase); }) {
+            policy.beginPhase(phase);
+        }
+    });
+}
+
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
+template <BenchPhase phase>
+void VerilatorBench<TopModule, Policies...>::endPhase() {
+    forEachPolicy([](auto& policy) {
+        if constexpr (requires { policy.endPhase(phase); }) {
+            policy.endPhase(phase);
+        }
+    });
+}
+
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
+void VerilatorBench<TopModule, Policies...>::reset() {
     topmodule->rst = 1;
     this->advanceCycle();
     topmodule->rst = 0;
     cycles = 0; // zeroth cycle after reset
+    forEachPolicy([this](auto& policy) {
+        if constexpr (requires { policy.onReset(topmodule); }) {
+            policy.onReset(topmodule);
+        }
+    });
 }
 
-template <VerilatedToplevel TopModule>
+template <VerilatedToplevel TopModule, BenchPolicy... Policies>
 template <ClkEdgeHandler<TopModule> RiseEdgeHandler,
           ClkEdgeHandler<TopModule> FallEdgeHandler>
-void VerilatorBench<TopModule>::advanceCycle(RiseEdgeHandler handleClkRising,
-                                             FallEdgeHandler handleClkFalling) {
+void VerilatorBench<TopModule, Policies...>::advanceCycle(
+    RiseEdgeHandler handleClkRising, FallEdgeHandler handleClkFalling) {
     ++cycles;
+    forEachPolicy([this](auto& policy) {
+        if constexpr (requires { policy.beforeCycle(topmodule, cycles); }) {
+            policy.beforeCycle(topmodule, cycles);
+        }
+    });
 
     // settle combinatorial logic from changed inputs
+    beginPhase<BenchPhase::Settle>();
     topmodule->clk = 0;
     topmodule->eval_step();
     topmodule->eval_end_step();
+    endPhase<BenchPhase::Settle>();
 
     // rising edge of clock
+    beginPhase<BenchPhase::EvalRise>();
     topmodule->clk = 1;
     topmodule->eval_step();
     topmodule->eval_end_step();
+    endPhase<BenchPhase::EvalRise>();
+    beginPhase<BenchPhase::RiseHandler>();
     handleClkRising(topmodule);
+    endPhase<BenchPhase::RiseHandler>();
 
     // falling edge of clock
+    beginPhase<BenchPhase::EvalFall>();
     topmodule->clk = 0;
     topmodule->eval_step();
     topmodule->eval_end_step();
+    endPhase<BenchPhase::EvalFall>();
+    beginPhase<BenchPhase::FallHandler>();
     handleClkFalling(topmodule);
+    endPhase<BenchPhase::FallHandler>();
+
+    forEachPolicy([this](auto& policy) {
+        if constexpr (requires { policy.afterCycle(topmodule, cycles); }) {
+            policy.afterCycle(topmodule, cycles);
+        }
+    });
 }
 
 } // namespace vsc
 
-#include "VSC/internal/CvsUnsetMacros.h" // keep internal macros private
+#include "VSC/internal/UnsetMacros.h" // keep internal macros private
 
 #endif /* VERILATOR_BENCH_H_ */
@@ -0,0 +1,152 @@
+/** @file
+ * GDB remote serial protocol stub for simulated CPU cores.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_GDB_STUB_H_
+#define VSC_GDB_STUB_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vsc {
+
+/**
+ * A simulated core as seen by the debugger
+ *
+ * Registers and memory are accessed through backdoors into the model (e.g. rootp
+ * signals and memory arrays), never by simulating debug module transactions, and only
+ * while the simulation is halted. Registers are numbered as in the architecture's GDB
+ * register layout and transferred little endian.
+ */
+class GdbTarget {
+public:
+    virtual ~GdbTarget() = default;
+
+    virtual std::size_t registerCount() const = 0;
+    virtual std::size_t registerBytes(std::size_t reg) const = 0;
+    virtual std::uint64_t readRegister(std::size_t reg) = 0;
+    virtual void writeRegister(std::size_t reg, std::uint64_t value) = 0;
+    /**
+     * Index of the program counter, used to resume at an address.
+     */
+    virtual std::size_t pcRegister() const = 0;
+    /**
+     * Backdoor memory access.
+     * @return false if any part of the range is not mapped
+     */
+    virtual bool readMemory(std::uint64_t address, std::span<std::uint8_t> data) = 0;
+    virtual bool writeMemory(std::uint64_t address,
+                             std::span<const std::uint8_t> data) = 0;
+    /**
+     * GDB target description XML, e.g. naming the architecture. Empty lets GDB assume
+     * the architecture it was started for.
+     */
+    virtual std::string targetDescription() const { return {}; }
+};
+
+enum class GdbStopReason { Interrupt, Breakpoint, Step };
+enum class GdbResume { Continue, Detach, Kill };
+
+/**
+ * Serves one GDB connection over a Unix domain socket or a pair of file descriptors
+ *
+ * The stub never runs on its own; the bench drives it from its simulation loop:
+ *
+ *   GdbStub gdb(target, "/tmp/soc.gdb");
+ *   while (running) {
+ *       bench.advanceCycle(...);
+ *       if (retired && gdb.shouldHalt(pc)) {
+ *           running = gdb.halt() != GdbResume::Kill;
+ *       }
+ *       if ((bench.getCycles() & 0xfff) == 0) {
+ *           gdb.poll(); // accept connections, notice Ctrl-C
+ *       }
+ *   }
+ *
+ * shouldHalt() is an inline flag test while no breakpoint is set, no step is pending and
+ * no interrupt arrived, so an attached but running debugger costs nothing per cycle.
+ * halt() blocks and services the debugger until it resumes the target. Breakpoints are
+ * kept in the stub and compared against the retired pc, so memory is never patched.
+ *
+ * GDB connects to a socket through a pipe, e.g.
+ *   target remote | socat - UNIX-CONNECT:/tmp/soc.gdb
+ * and to a stdio stub with target remote | ./bench --gdb-stdio, in which case the bench
+ * must not write to stdout.
+ */
+class GdbStub {
+private:
+    GdbTarget& target;
+    int listenFd;
+    int inFd;
+    int outFd;
+    bool isSocket;
+    std::string socketPath;
+    std::string received;
+    std::vector<std::uint64_t> breakpoints;
+    bool noAck;
+    bool stepping;
+    bool interruptRequested;
+    bool attachPending;
+    bool awaitingStop; // the debugger resumed the target and waits for a stop reply
+    bool armed;        // any reason for shouldHalt() to look at the pc
+    GdbStopReason pendingReason;
+    int lastSignal;
+
+    void updateArmed();
+    void closeConnection();
+    bool readAvailable(int timeoutMs);
+    bool nextPacket(std::string& packet);
+    void sendRaw(const std::string& bytes);
+    void sendPacket(const std::string& data);
+    bool slowShouldHalt(std::uint64_t pc);
+    std::string handleQuery(const std::string& packet);
+    std::string readRegisters();
+    std::string writeRegisters(const std::string& hex);
+    std::string readMemory(const std::string& args);
+    std::string writeMemory(const std::string& args, bool binary);
+    std::string updateBreakpoint(const std::string& args, bool insert);
+
+public:
+    /**
+     * Listen on a Unix domain socket, replacing a stale socket file. Throws
+     * std::runtime_error on failure.
+     */
+    GdbStub(GdbTarget& target, const std::string& socketPath);
+    /**
+     * Talk to a debugger that is already connected through the given descriptors, e.g.
+     * STDIN_FILENO and STDOUT_FILENO. The descriptors are not closed.
+     */
+    GdbStub(GdbTarget& target, int inFd, int outFd);
+    ~GdbStub();
+
+    bool isConnected() const { return inFd >= 0; }
+    /**
+     * Check for a new connection or an interrupt without blocking.
+     * @return true if the target should halt at the next shouldHalt()
+     */
+    bool poll();
+    /**
+     * Call after every retired instruction with the address of the next one.
+     * @return true if the simulation must call halt() before executing further
+     */
+    bool shouldHalt(std::uint64_t pc) { return armed && slowShouldHalt(pc); }
+    /**
+     * Report the stop to the debugger and serve it until it resumes the target. A
+     * reason is only needed when the bench halts on its own, e.g. on an ebreak; without
+     * a connected debugger this returns right away.
+     */
+    GdbResume halt();
+    GdbResume halt(GdbStopReason reason);
+
+    GdbStub(const GdbStub& other) = delete;
+    GdbStub& operator=(const GdbStub& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_GDB_STUB_H_ */
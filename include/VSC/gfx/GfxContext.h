@@ -0,0 +1,33 @@
+/** @file
+ * Lazy initialization of the windowing system.
+ *
+ * Part of VSC::gfx. Headless benches link VSC::core only and never touch GLFW.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_GFX_CONTEXT_H_
+#define VSC_GFX_CONTEXT_H_
+
+namespace vsc {
+
+/**
+ * Initialize GLFW on first use; later calls return immediately. GLFW is terminated at
+ * process exit. Must be called from the main thread, like every other GLFW call.
+ * Throws std::logic_error if called from a thread other than the one that called it
+ * first, and std::runtime_error if initialization failed, e.g. because no display is
+ * available.
+ */
+void ensureGfxInitialized();
+/**
+ * Check whether GLFW has been initialized, without initializing it.
+ */
+bool isGfxInitialized();
+/**
+ * Check whether Vulkan presentation is available. Initializes GLFW if needed.
+ */
+bool isVulkanSupported();
+
+} // namespace vsc
+
+#endif /* VSC_GFX_CONTEXT_H_ */
@@ -12,6 +12,7 @@
  */
 
 #ifndef VSC_MACROS_SET__
+#define VSC_MACROS_SET__
 /**
  * Macro to mark function parameter as unused to squash warnings.
  * WARNING: this is an unstable API intended for internal use, and may break naming at any
@@ -9,4 +9,5 @@
 
 #ifdef VSC_MACROS_SET__
 #undef VSC_UNUSED__
+#undef VSC_MACROS_SET__
 #endif // VSC_MACROS_SET__
@@ -0,0 +1,166 @@
+/** @file
+ * Parallel (DVP) camera source fed from video files or a test pattern.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_DVP_CAMERA_H_
+#define VSC_DVP_CAMERA_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vsc {
+
+enum class DvpPixelFormat {
+    Gray8,  // one byte per pixel, luma
+    Rgb565, // two bytes per pixel, high byte first
+    Yuv422, // YUYV, two bytes per pixel
+};
+
+struct DvpOptions {
+    DvpPixelFormat format = DvpPixelFormat::Rgb565;
+    unsigned width = 640; // raw files and the test pattern, Y4M files bring their own
+    unsigned height = 480;
+    unsigned vsyncClocks = 64;      // VSYNC pulse at the start of each frame
+    unsigned backPorchClocks = 64;  // after VSYNC, before the first line
+    unsigned hblankClocks = 32;     // between lines
+    unsigned frontPorchClocks = 64; // after the last line
+    bool vsyncActiveHigh = true;
+    bool loop = false;         // restart files at their end
+    unsigned patternFrames = 0; // frames of test pattern, 0 for no end
+    unsigned bufferFrames = 4;  // frames converted ahead of the simulation
+};
+
+/**
+ * Camera side of the DVP pins for one PCLK cycle
+ */
+struct DvpPins {
+    bool vsync = false;
+    bool href = false;
+    std::uint8_t data = 0;
+};
+
+struct DvpCameraStats {
+    std::uint64_t framesSent = 0;
+    std::uint64_t stalls = 0; // frames after the first the simulation had to wait for
+};
+
+/**
+ * Image sensor with an 8-bit DVP output (PCLK, VSYNC, HREF, D[7:0])
+ *
+ * Frames come from a YUV4MPEG2 (.y4m) file with 8-bit 4:2:0, 4:2:2, 4:4:4 or mono
+ * samples, from a raw file of frames already in the output format, or, with an empty
+ * path, from a generated test pattern: colour bars, a moving block, and the frame number
+ * in binary as white and black pixels at the start of the first line.
+ *
+ * A prefetch thread reads and converts frames into a ring of bufferFrames frame
+ * buffers allocated up front. step() then only copies the next byte out of the current
+ * buffer, and takes the next buffer at each VSYNC. The simulation waits only if
+ * conversion cannot keep up, which is counted as a stall.
+ *
+ * step() is called once per PCLK with the camera driving new levels, e.g. on the falling
+ * edge when the design samples on the rising edge:
+ *   const DvpPins& pins = camera.step();
+ *   top->cam_vsync = pins.vsync; top->cam_href = pins.href; top->cam_d = pins.data;
+ */
+class DvpCamera {
+private:
+    enum class Source { Y4m, Raw, Pattern };
+    enum class Phase { Start, Vsync, BackPorch, Line, Hblank, FrontPorch, Done };
+
+    DvpOptions options;
+    Source source;
+    unsigned width;
+    unsigned height;
+    std::size_t lineBytes;
+    std::size_t frameBytes;
+    DvpCameraStats stats;
+
+    // source, used by the prefetch thread only
+    std::ifstream file;
+    std::streampos firstFrame;
+    unsigned chromaShiftX;
+    unsigned chromaShiftY;
+    bool chroma;
+    std::vector<std::uint8_t> planes;  // one Y4M frame
+    std::vector<std::uint8_t> yuvLine; // Y, U, V per pixel
+    std::uint64_t produced;
+
+    // ring of converted frames
+    std::vector<std::vector<std::uint8_t>> buffers;
+    std::mutex lock;
+    std::condition_variable_any changed;
+    std::size_t readIndex;
+    std::size_t writeIndex;
+    std::size_t ready;
+    bool holding; // the simulation is sending a buffer
+    bool sourceEnded;
+    std::exception_ptr error;
+
+    // pin state
+    Phase phase;
+    const std::uint8_t* current;
+    std::size_t pos;
+    unsigned line;
+    unsigned countdown;
+    DvpPins pins;
+
+    std::jthread prefetcher; // last, so it stops before the state above goes away
+
+    void openY4m(const std::string& path);
+    bool produceFrame(std::uint8_t* out);
+    bool readY4mFrame(std::uint8_t* out);
+    void renderPattern(std::uint8_t* out);
+    void packLine(std::uint8_t* out) const;
+    void prefetch(std::stop_token stop);
+    bool acquireFrame();
+    void releaseFrame();
+    void advance();
+
+public:
+    /**
+     * Open a .y4m file, a raw frame file, or the test pattern for an empty path, and
+     * start converting frames. Throws std::runtime_error if the file cannot be opened
+     * or its format is not supported.
+     */
+    explicit DvpCamera(const std::string& path, const DvpOptions& options = {});
+    ~DvpCamera();
+
+    unsigned getWidth() const { return width; }
+    unsigned getHeight() const { return height; }
+    const DvpCameraStats& getStats() const { return stats; }
+    /**
+     * Whether the last frame has been sent completely; the pins stay idle from then on.
+     */
+    bool done() const { return phase == Phase::Done; }
+
+    /**
+     * Levels for the next PCLK. Rethrows errors from reading the source at the start of
+     * the frame they affect.
+     */
+    const DvpPins& step() {
+        if (phase == Phase::Line && countdown > 0) { // fast path within a line
+            --countdown;
+            pins.data = current[pos++];
+            return pins;
+        }
+        advance();
+        return pins;
+    }
+
+    DvpCamera(const DvpCamera& other) = delete;
+    DvpCamera& operator=(const DvpCamera& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_DVP_CAMERA_H_ */
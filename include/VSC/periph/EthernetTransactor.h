@@ -0,0 +1,166 @@
+/** @file
+ * Ethernet MII/RGMII transactor replaying and recording pcap files.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_ETHERNET_TRANSACTOR_H_
+#define VSC_ETHERNET_TRANSACTOR_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "VSC/periph/Pcap.h"
+
+namespace vsc {
+
+enum class EthernetInterface {
+    Mii,   // one nibble per clock, low nibble first
+    Rgmii, // one byte per clock, low nibble on the rising and high nibble on the falling
+           // edge
+};
+
+/**
+ * Pin levels for one clock of the data path. In MII mode data is a nibble. In RGMII mode
+ * data is a byte and the control line carries valid on the rising edge and
+ * valid ^ error on the falling edge; see toRgmii() and fromRgmii().
+ */
+struct EthernetLane {
+    bool valid = false;
+    bool error = false;
+    std::uint8_t data = 0;
+};
+
+struct EthernetOptions {
+    EthernetInterface interface = EthernetInterface::Mii;
+    std::uint64_t bitsPerSecond = 100'000'000; // converts clocks to capture timestamps
+    unsigned interFrameGap = 12;               // idle bytes after each frame
+    bool appendFcs = true; // pad input frames and add their FCS, missing in most captures
+    bool stripFcs = true;  // record frames without their FCS
+    /**
+     * Start no input frame before its capture time, relative to the first packet, so
+     * traffic keeps the bursts and pauses of the original capture.
+     */
+    bool paceByTimestamps = false;
+};
+
+struct EthernetStats {
+    std::uint64_t framesSent = 0;     // to the design
+    std::uint64_t framesReceived = 0; // from the design
+    std::uint64_t fcsErrors = 0;
+    std::uint64_t alignmentErrors = 0; // odd nibble counts or a broken preamble
+    std::uint64_t lengthErrors = 0;    // runts, and frames too long for the buffers
+    std::uint64_t codeErrors = 0;      // frames with the error line asserted
+};
+
+/**
+ * PHY side of a MAC's MII or RGMII interface
+ *
+ * Frames from an input capture are sent to the design's receive pins with preamble, SFD,
+ * padding and FCS, separated by the inter-frame gap. Frames the design transmits are
+ * collected, checked and appended to an output capture with a timestamp derived from
+ * the clock count and the link speed.
+ *
+ * Each frame is assembled once in a fixed buffer, with its FCS computed over the whole
+ * frame, and the per-clock calls only index into it; received frames are checked once
+ * they end. Nothing is allocated after construction.
+ *
+ * Both directions are clocked by the bench, once per clock of the respective interface
+ * clock:
+ *   const EthernetLane rx = eth.nextRx();
+ *   top->rx_dv = rx.valid; top->rxd = rx.data;
+ *   eth.tx({top->tx_en, top->tx_er, top->txd});
+ */
+class EthernetTransactor {
+public:
+    static constexpr std::size_t maxFrameBytes = 16384; // including FCS, for jumbo frames
+    static constexpr std::size_t minFrameBytes = 64;
+    static constexpr std::size_t preambleBytes = 8;     // including SFD
+
+private:
+    std::optional<PcapReader> input;
+    std::optional<PcapWriter> output;
+    EthernetOptions options;
+    EthernetStats stats;
+    unsigned symbolsPerByte;
+
+    // to the design
+    std::size_t nextPacket;
+    std::uint64_t rxSymbols;
+    std::uint64_t gapSymbols;
+    std::array<std::uint8_t, preambleBytes + maxFrameBytes> rxWire;
+    std::size_t rxLength;
+    std::size_t rxPos;
+    bool rxHighNibble;
+
+    // from the design
+    std::uint64_t txSymbols;
+    std::uint64_t txStart;
+    std::array<std::uint8_t, maxFrameBytes> txFrame;
+    std::size_t txLength;
+    std::uint8_t txNibble; // low nibble waiting for its high nibble
+    bool txActive;
+    bool txPreamble;
+    bool txHighNibble;
+    bool txError;
+    bool txOverflow;
+    bool txMisaligned;
+
+    bool loadNextFrame();
+    void receiveByte(std::uint8_t byte);
+    void finishFrame();
+    std::uint64_t timestampNs(std::uint64_t symbols) const;
+
+public:
+    /**
+     * @param inputPath capture to send to the design, empty for none
+     * @param outputPath capture to record transmitted frames to, empty for none
+     * Throws std::runtime_error if a capture cannot be opened or is not Ethernet.
+     */
+    EthernetTransactor(const std::string& inputPath, const std::string& outputPath,
+                       const EthernetOptions& options = {});
+
+    const EthernetStats& getStats() const { return stats; }
+    /**
+     * Whether every input frame has been sent completely.
+     */
+    bool inputDone() const {
+        return rxPos >= rxLength && (!input || nextPacket >= input->size());
+    }
+    void flush();
+
+    /**
+     * Receive pins of the design for the next clock.
+     */
+    EthernetLane nextRx();
+    /**
+     * Transmit pins of the design, sampled once per clock.
+     */
+    void tx(const EthernetLane& lane);
+
+    /**
+     * Split an RGMII lane into the levels of the rising and the falling clock edge.
+     */
+    static void toRgmii(const EthernetLane& lane, std::uint8_t& risingData,
+                        bool& risingCtl, std::uint8_t& fallingData, bool& fallingCtl) {
+        risingData = lane.data & 0xf;
+        risingCtl = lane.valid;
+        fallingData = lane.data >> 4;
+        fallingCtl = lane.valid != lane.error;
+    }
+    /**
+     * Combine the RGMII levels sampled on the rising and the falling clock edge.
+     */
+    static EthernetLane fromRgmii(std::uint8_t risingData, bool risingCtl,
+                                  std::uint8_t fallingData, bool fallingCtl) {
+        return {risingCtl, risingCtl != fallingCtl,
+                static_cast<std::uint8_t>((risingData & 0xf) | (fallingData & 0xf) << 4)};
+    }
+};
+
+} // namespace vsc
+
+#endif /* VSC_ETHERNET_TRANSACTOR_H_ */
@@ -0,0 +1,229 @@
+/** @file
+ * Serial line codes: 8b/10b, Manchester and the 64b/66b scrambler.
+ *
+ * Codes are handled as integers in transmission order: bit 0 (8b/10b bit a, the first
+ * Manchester chip, the first scrambled bit) goes on the line first, as serializers shift
+ * out the least significant bit first. Words of several symbols hold the first symbol in
+ * their lowest bits. Everything works a symbol or a word at a time through tables and
+ * bit operations, never bit by bit.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_LINE_CODE_H_
+#define VSC_LINE_CODE_H_
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+
+namespace vsc {
+
+namespace internal {
+/**
+ * 8b/10b encoding by running disparity, control flag and byte (rd << 9 | k << 8 | byte):
+ * the code in bits 0-9, the new running disparity in bit 10 and bit 11 set for control
+ * symbols that do not exist.
+ */
+extern const std::array<std::uint16_t, 1024> encode8b10bTable;
+/**
+ * 8b/10b decoding by running disparity and code (rd << 10 | code): the byte in bits 0-7,
+ * the control flag in bit 8, the new running disparity in bit 9, a code error in bit 10
+ * and a disparity error in bit 11.
+ */
+extern const std::array<std::uint16_t, 2048> decode8b10bTable;
+
+constexpr std::uint64_t spreadBits(std::uint32_t value) {
+    std::uint64_t x = value;
+    x = (x | x << 16) & 0x0000ffff0000ffff;
+    x = (x | x << 8) & 0x00ff00ff00ff00ff;
+    x = (x | x << 4) & 0x0f0f0f0f0f0f0f0f;
+    x = (x | x << 2) & 0x3333333333333333;
+    x = (x | x << 1) & 0x5555555555555555;
+    return x;
+}
+
+constexpr std::uint32_t compactBits(std::uint64_t value) {
+    std::uint64_t x = value & 0x5555555555555555;
+    x = (x | x >> 1) & 0x3333333333333333;
+    x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0f;
+    x = (x | x >> 4) & 0x00ff00ff00ff00ff;
+    x = (x | x >> 8) & 0x0000ffff0000ffff;
+    x = (x | x >> 16) & 0x00000000ffffffff;
+    return static_cast<std::uint32_t>(x);
+}
+} // namespace internal
+
+struct Symbol8b10b {
+    std::uint8_t data = 0;
+    bool control = false;
+    bool codeError = false;      // not a valid code in either disparity
+    bool disparityError = false; // valid, but not allowed at the current disparity
+};
+
+/**
+ * 8b/10b encoder with running disparity (IEEE 802.3 clause 36)
+ *
+ * One table lookup per symbol. Encoding one of the twelve control symbols (K28.0-K28.7,
+ * K23.7, K27.7, K29.7, K30.7) requires control to be set; other control values throw
+ * std::runtime_error.
+ */
+class Encoder8b10b {
+private:
+    unsigned disparity; // 0 for RD-, 1 for RD+
+
+public:
+    explicit Encoder8b10b(bool positive = false) : disparity{positive ? 1u : 0u} {}
+
+    bool isPositive() const { return disparity != 0; }
+
+    std::uint16_t encode(std::uint8_t byte, bool control = false) {
+        const std::uint16_t entry =
+            internal::encode8b10bTable[disparity << 9 | (control ? 1u : 0u) << 8 | byte];
+        if (entry & 0x800) {
+            throw std::runtime_error("not an 8b/10b control symbol");
+        }
+        disparity = (entry >> 10) & 1;
+        return entry & 0x3ff;
+    }
+    /**
+     * Encode the four bytes of a word, least significant first, into 40 bits.
+     * @param controlMask bit i marks byte i as a control symbol
+     */
+    std::uint64_t encodeWord(std::uint32_t word, unsigned controlMask = 0) {
+        std::uint64_t codes = 0;
+        for (unsigned i = 0; i < 4; ++i) {
+            const auto byte = static_cast<std::uint8_t>(word >> (8 * i));
+            codes |= static_cast<std::uint64_t>(encode(byte, (controlMask >> i) & 1))
+                     << (10 * i);
+        }
+        return codes;
+    }
+};
+
+/**
+ * 8b/10b decoder tracking the running disparity
+ *
+ * Codes with a disparity error are still decoded, and the running disparity follows the
+ * received code so one error does not cascade.
+ */
+class Decoder8b10b {
+private:
+    unsigned disparity;
+
+public:
+    explicit Decoder8b10b(bool positive = false) : disparity{positive ? 1u : 0u} {}
+
+    bool isPositive() const { return disparity != 0; }
+
+    Symbol8b10b decode(std::uint16_t code) {
+        const std::uint16_t entry =
+            internal::decode8b10bTable[disparity << 10 | (code & 0x3ff)];
+        disparity = (entry >> 9) & 1;
+        return {static_cast<std::uint8_t>(entry), (entry & 0x100) != 0,
+                (entry & 0x400) != 0, (entry & 0x800) != 0};
+    }
+    /**
+     * Decode four codes from the low 40 bits, first code in bits 0-9.
+     * @param controlMask set to the control flags, bit i for byte i
+     * @param errorMask set to the code or disparity errors, bit i for byte i
+     */
+    std::uint32_t decodeWord(std::uint64_t codes, unsigned& controlMask,
+                             unsigned& errorMask) {
+        std::uint32_t word = 0;
+        controlMask = 0;
+        errorMask = 0;
+        for (unsigned i = 0; i < 4; ++i) {
+            const auto code = static_cast<std::uint16_t>(codes >> (10 * i));
+            const Symbol8b10b symbol = decode(code);
+            word |= static_cast<std::uint32_t>(symbol.data) << (8 * i);
+            controlMask |= (symbol.control ? 1u : 0u) << i;
+            errorMask |= (symbol.codeError || symbol.disparityError ? 1u : 0u) << i;
+        }
+        return word;
+    }
+};
+
+enum class ManchesterConvention {
+    Ieee,   // IEEE 802.3: 0 is high-low, 1 is low-high
+    Thomas, // G. E. Thomas: 0 is low-high, 1 is high-low
+};
+
+/**
+ * Manchester encode 32 bits, least significant first, into 64 chips.
+ */
+template <ManchesterConvention Convention = ManchesterConvention::Ieee>
+constexpr std::uint64_t manchesterEncode(std::uint32_t bits) {
+    const std::uint64_t ones = internal::spreadBits(bits);
+    const std::uint64_t zeros = internal::spreadBits(~bits);
+    // the chip pair of a bit is (first, second) = (bit 2i, bit 2i + 1)
+    if constexpr (Convention == ManchesterConvention::Ieee) {
+        return zeros | ones << 1;
+    } else {
+        return ones | zeros << 1;
+    }
+}
+
+/**
+ * Manchester decode 64 chips into 32 bits.
+ * @param errors set to a mask of the bits whose two chips were equal
+ */
+template <ManchesterConvention Convention = ManchesterConvention::Ieee>
+constexpr std::uint32_t manchesterDecode(std::uint64_t chips, std::uint32_t& errors) {
+    const std::uint32_t first = internal::compactBits(chips);
+    const std::uint32_t second = internal::compactBits(chips >> 1);
+    errors = ~(first ^ second);
+    return Convention == ManchesterConvention::Ieee ? second : first;
+}
+
+/**
+ * 64b/66b sync headers, sent before the payload and never scrambled
+ */
+inline constexpr std::uint8_t sync64b66bData = 0b10;    // 0 then 1 on the line
+inline constexpr std::uint8_t sync64b66bControl = 0b01; // 1 then 0 on the line
+
+/**
+ * Self-synchronizing 64b/66b payload scrambler, x^58 + x^39 + 1 (IEEE 802.3 clause 49)
+ *
+ * A whole payload is scrambled with three shifts and xors instead of 64 iterations of
+ * the serial LFSR: bits that depend on earlier bits of the same payload are fixed up in
+ * two passes, the first 39 bits depending only on the previous payload.
+ */
+class Scrambler64b66b {
+private:
+    std::uint64_t state; // the last 64 scrambled bits, most recent in bit 63
+
+public:
+    explicit Scrambler64b66b(std::uint64_t seed = ~std::uint64_t{0}) : state{seed} {}
+
+    std::uint64_t scramble(std::uint64_t payload) {
+        std::uint64_t out = payload ^ (state >> 6) ^ (state >> 25);
+        out ^= out << 39;
+        out ^= out << 58;
+        state = out;
+        return out;
+    }
+};
+
+/**
+ * Descrambler matching Scrambler64b66b. It synchronizes itself after 58 received bits,
+ * whatever its seed.
+ */
+class Descrambler64b66b {
+private:
+    std::uint64_t state;
+
+public:
+    explicit Descrambler64b66b(std::uint64_t seed = ~std::uint64_t{0}) : state{seed} {}
+
+    std::uint64_t descramble(std::uint64_t payload) {
+        const std::uint64_t out = payload ^ (payload << 39 | state >> 25) ^
+                                  (payload << 58 | state >> 6);
+        state = payload;
+        return out;
+    }
+};
+
+} // namespace vsc
+
+#endif /* VSC_LINE_CODE_H_ */
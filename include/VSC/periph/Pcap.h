@@ -0,0 +1,83 @@
+/** @file
+ * Reading and writing packet captures in the classic pcap format.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_PCAP_H_
+#define VSC_PCAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace vsc {
+
+inline constexpr std::uint32_t pcapLinkEthernet = 1;
+
+struct PcapPacket {
+    std::uint64_t timestampNs = 0;
+    std::uint32_t originalLength = 0; // on the wire, more than data if truncated
+    std::span<const std::uint8_t> data;
+};
+
+/**
+ * A whole capture file in memory
+ *
+ * The file is read once and indexed; packets are views into that buffer, so iterating
+ * them during simulation does not allocate. Both byte orders and microsecond and
+ * nanosecond timestamps are accepted.
+ */
+class PcapReader {
+private:
+    std::vector<std::uint8_t> contents;
+    std::vector<PcapPacket> packets;
+    std::uint32_t linkType;
+
+public:
+    /**
+     * Throws std::runtime_error if the file cannot be read or is not a pcap file.
+     */
+    explicit PcapReader(const std::string& path);
+
+    std::uint32_t getLinkType() const { return linkType; }
+    std::size_t size() const { return packets.size(); }
+    const PcapPacket& operator[](std::size_t index) const { return packets[index]; }
+    std::span<const PcapPacket> getPackets() const { return packets; }
+
+    PcapReader(const PcapReader& other) = delete;
+    PcapReader& operator=(const PcapReader& other) = delete;
+};
+
+/**
+ * Capture file writer with nanosecond timestamps
+ */
+class PcapWriter {
+private:
+    std::ofstream out;
+    std::string path;
+    std::uint32_t snapLength;
+
+public:
+    /**
+     * Create the file and write its header. Throws std::runtime_error on failure.
+     */
+    explicit PcapWriter(const std::string& path,
+                        std::uint32_t linkType = pcapLinkEthernet,
+                        std::uint32_t snapLength = 65535);
+
+    /**
+     * Append a packet, truncated to the snap length.
+     * @param originalLength length on the wire, or 0 for the size of data
+     */
+    void write(std::uint64_t timestampNs, std::span<const std::uint8_t> data,
+               std::uint32_t originalLength = 0);
+    void flush();
+};
+
+} // namespace vsc
+
+#endif /* VSC_PCAP_H_ */
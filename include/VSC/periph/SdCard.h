@@ -0,0 +1,220 @@
+/** @file
+ * SD card model backed by a memory-mapped disk image.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_SD_CARD_H_
+#define VSC_SD_CARD_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+
+namespace vsc {
+
+struct SdCardOptions {
+    bool writeBack = false;     // write to the image file instead of a private copy
+    bool writeProtect = false;  // reject all writes
+    unsigned accessDelay = 2;   // clocks (native) or bytes (SPI) before read data starts
+    unsigned busyDelay = 8;     // clocks or bytes of busy after writes and R1b responses
+};
+
+/**
+ * Card side of the native bus pins. A line is driven when its enable bit is set and
+ * pulled up by the host otherwise.
+ */
+struct SdNativePins {
+    bool cmd = true;
+    bool cmdEnable = false;
+    std::uint8_t dat = 0xf;
+    std::uint8_t datEnable = 0;
+};
+
+struct SdCardStats {
+    std::uint64_t commands = 0;
+    std::uint64_t blocksRead = 0;
+    std::uint64_t blocksWritten = 0;
+    std::uint64_t crcErrors = 0;
+};
+
+/**
+ * High capacity (SDHC/SDXC) card in SPI or native 1/4-bit mode
+ *
+ * The disk image is mapped into memory, privately unless writeBack is set, and block
+ * transfers are served from it a whole block at a time: when a block starts, its 512
+ * bytes are copied and expanded into the exact bit sequence of the bus, CRCs included,
+ * so each bus clock afterwards costs one load. Written blocks are collected the same way
+ * and checked and stored once complete. Multi-block transfers prepare each following
+ * block as soon as the previous one is sent.
+ *
+ * Both pin interfaces take the pin levels once per simulated cycle and detect clock
+ * edges themselves, so they can be called unconditionally from an edge handler:
+ *   - SPI (mode 0): miso = card.spiStep(sclk, csn, mosi), or spiExchange() per byte for
+ *     byte-level SPI transactors
+ *   - native: pins = card.nativeStep(clk, cmd, dat), sampling on the rising and driving
+ *     on the falling clock edge (default speed timing)
+ *
+ * Supported commands cover initialization, CID/CSD/SCR/status reads, CMD6 queries (only
+ * the default functions), single and multiple block reads and writes, erase and bus
+ * width selection. Reads past the end of the image report an out of range error.
+ */
+class SdCard {
+public:
+    static constexpr std::size_t blockBytes = 512;
+
+private:
+    enum class State { Idle, Ready, Ident, Standby, Transfer, Data, Receive, Program };
+    enum class Response { None, R1, R1b, R2, R3, R6, R7 };
+    enum class Transfer { None, ReadBlocks, WriteBlocks, ReadRegister };
+    enum class WritePhase { Token, Data, Crc, End };
+
+    struct Reply {
+        Response kind;
+        std::uint32_t value; // card status, OCR, RCA and status, or check pattern
+        const std::uint8_t* longValue; // CID or CSD for R2
+    };
+
+    // 4-bit read frame: start, 1024 data nibbles, 16 CRC nibbles, end
+    static constexpr std::size_t maxFrameSymbols = 1 + 8 * blockBytes + 16 + 1;
+    // SPI frame: access delay, token, data, CRC
+    static constexpr std::size_t maxSpiBytes = 64 + 1 + blockBytes + 2;
+
+    std::uint8_t* image;
+    std::size_t imageBytes;
+    std::uint64_t blockCount;
+    SdCardOptions options;
+    SdCardStats stats;
+
+    // card state
+    State state;
+    bool initialized;
+    bool appCommand;
+    bool wideBus;
+    bool spiCrc;
+    std::uint16_t rca;
+    std::uint32_t errorBits; // reported once in the next card status
+    std::uint64_t eraseStart;
+    std::uint64_t eraseEnd;
+    std::array<std::uint8_t, 16> cid;
+    std::array<std::uint8_t, 16> csd;
+
+    // data transfer
+    Transfer transfer;
+    bool multiBlock;
+    std::uint64_t nextBlock;
+    std::array<std::uint8_t, 64> registerData;
+    std::size_t registerBytes;
+    std::array<std::uint8_t, blockBytes + 2> block; // write data and CRC
+    WritePhase writePhase;
+    std::size_t writeCount;
+
+    // native framing
+    bool lastClk;
+    SdNativePins pins;
+    std::uint64_t cmdShift;
+    unsigned cmdBits;
+    std::array<std::uint8_t, 17> response;
+    unsigned responseBits;
+    unsigned responsePos;
+    unsigned responseDelay;
+    bool busyAfterResponse;
+    unsigned busyClocks;
+    std::array<std::uint8_t, maxFrameSymbols> frame; // one DAT nibble per clock
+    std::size_t frameLength;
+    std::size_t framePos;
+    unsigned frameDelay;
+    std::array<std::uint16_t, 4> lineCrc;
+
+    // SPI framing
+    bool spiLastClk;
+    bool spiSelected;
+    unsigned spiBits;
+    std::uint8_t spiInShift;
+    std::uint8_t spiOutShift;
+    std::uint8_t spiNext;
+    std::array<std::uint8_t, 6> spiCommand;
+    unsigned spiCommandBytes;
+    std::array<std::uint8_t, maxSpiBytes> spiOut;
+    std::size_t spiOutLength;
+    std::size_t spiOutPos;
+    unsigned spiBusy;
+
+    void resetCard();
+    std::uint32_t cardStatus(State reported);
+    std::uint8_t spiR1();
+    Reply execute(unsigned index, std::uint32_t argument, bool spi);
+    Reply executeApp(unsigned index, std::uint32_t argument, bool spi, bool& handled);
+    bool startRead(std::uint64_t address, bool multi);
+    bool startWrite(std::uint64_t address, bool multi);
+    void startRegisterRead(std::size_t bytes);
+    void stopTransfer();
+    unsigned commitWrite(bool crcValid); // CRC status / data response code
+    void endBusy();
+
+    void nativeRising(bool cmd, std::uint8_t dat);
+    void nativeFalling();
+    void nativeCommand(std::uint64_t bits);
+    void buildNativeFrame(const std::uint8_t* data, std::size_t bytes);
+    bool nextNativeFrame();
+    void receiveNative(std::uint8_t dat);
+
+    std::uint8_t spiProcess(std::uint8_t in);
+    void spiQueueReply(const Reply& reply);
+    void spiQueueData(const std::uint8_t* data, std::size_t bytes);
+    bool nextSpiFrame();
+    void receiveSpi(std::uint8_t in);
+
+public:
+    /**
+     * Map a disk image, whose size must be a multiple of 512 bytes. Throws
+     * std::runtime_error on failure.
+     */
+    explicit SdCard(const std::string& imagePath, const SdCardOptions& options = {});
+    ~SdCard();
+
+    std::uint64_t getBlockCount() const { return blockCount; }
+    const SdCardStats& getStats() const { return stats; }
+    /**
+     * Backdoor access to the card contents, e.g. to preload a bootloader's target RAM
+     * or to check written data.
+     */
+    std::span<std::uint8_t> getImage() { return {image, imageBytes}; }
+
+    /**
+     * Pin-level SPI mode 0. csn is active low; returns MISO (high while deselected).
+     */
+    bool spiStep(bool sclk, bool csn, bool mosi);
+    /**
+     * Byte-level SPI: the card receives in and returns the byte it sent meanwhile.
+     */
+    std::uint8_t spiExchange(std::uint8_t in) {
+        const std::uint8_t out = spiNext;
+        spiNext = spiProcess(in);
+        return out;
+    }
+    /**
+     * Native mode pins, called once per simulated cycle with the host's clock, the
+     * level of the CMD line and the levels of DAT[3:0].
+     */
+    const SdNativePins& nativeStep(bool clk, bool cmd, std::uint8_t dat) {
+        if (clk != lastClk) {
+            lastClk = clk;
+            if (clk) {
+                nativeRising(cmd, dat);
+            } else {
+                nativeFalling();
+            }
+        }
+        return pins;
+    }
+
+    SdCard(const SdCard& other) = delete;
+    SdCard& operator=(const SdCard& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_SD_CARD_H_ */
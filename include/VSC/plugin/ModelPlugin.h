@@ -0,0 +1,191 @@
+/** @file
+ * Plugin side of the model plugin interface.
+ *
+ * A plugin is a shared object containing one verilated model, its VerilatorBench and a
+ * thin adapter that drives one cycle:
+ *
+ *   struct Adapter {
+ *       Adapter(Bench& bench, int argc, const char* const* argv);
+ *       void cycle(Bench& bench) { bench.advanceCycle(onRise, onFall); }
+ *       bool finished(Bench& bench) const;  // optional
+ *       int exitCode() const;               // optional, default 0
+ *       void reset(Bench& bench);           // optional, default bench.reset()
+ *   };
+ *   using Bench = vsc::VerilatorBench<Vtop>;
+ *   VSC_DEFINE_MODEL_PLUGIN(Bench, Adapter)
+ *
+ * The cycle loop is instantiated inside the plugin, so the adapter's handlers are
+ * inlined into it exactly as in a standalone bench. Hosts load the plugin through
+ * PluginLibrary, e.g. with the vsc-run tool, and only cross the boundary once per
+ * batch of cycles.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_MODEL_PLUGIN_H_
+#define VSC_MODEL_PLUGIN_H_
+
+#include <concepts>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+#include <string>
+
+#include <verilated.h>
+
+#include "VSC/plugin/PluginAbi.h"
+
+namespace vsc {
+
+/**
+ * Model plugin adapter constraint, see ModelPlugin.h for the optional members
+ */
+template <typename Adapter, typename Bench>
+concept ModelPluginAdapter =
+    std::constructible_from<Adapter, Bench&, int, const char* const*> &&
+    requires(Adapter& adapter, Bench& bench) { adapter.cycle(bench); };
+
+namespace internal {
+
+/**
+ * One plugin instance: the model's context, the bench and the adapter
+ */
+template <typename Bench, ModelPluginAdapter<Bench> Adapter> class PluginInstance {
+private:
+    static VerilatedContext* withArgs(VerilatedContext* context, int argc,
+                                      const char* const* argv) {
+        context->commandArgs(argc, const_cast<const char**>(argv));
+        return context;
+    }
+
+public:
+    VerilatedContext context;
+    Bench bench;
+    Adapter adapter;
+    std::string error;
+    bool failed;
+
+    PluginInstance(int argc, const char* const* argv)
+        : context{},
+          bench{withArgs(&context, argc, argv)},
+          adapter{bench, argc, argv},
+          error{},
+          failed{false} {}
+
+    bool finished() {
+        if constexpr (requires { adapter.finished(bench); }) {
+            if (adapter.finished(bench)) {
+                return true;
+            }
+        }
+        return failed || context.gotFinish();
+    }
+    void fail(const char* what) {
+        error = what;
+        failed = true;
+    }
+
+    // C entry points of VscModelPluginApi
+    static void* create(int argc, const char* const* argv, char* error,
+                        size_t errorSize) {
+        try {
+            return new PluginInstance(argc, argv);
+        } catch (const std::exception& e) {
+            std::snprintf(error, errorSize, "%s", e.what());
+        } catch (...) {
+            std::snprintf(error, errorSize, "unknown exception");
+        }
+        return nullptr;
+    }
+    static void destroy(void* handle) { delete static_cast<PluginInstance*>(handle); }
+    static int reset(void* handle) {
+        auto& self = *static_cast<PluginInstance*>(handle);
+        try {
+            if constexpr (requires { self.adapter.reset(self.bench); }) {
+                self.adapter.reset(self.bench);
+            } else {
+                self.bench.reset();
+            }
+            return 0;
+        } catch (const std::exception& e) {
+            self.fail(e.what());
+        } catch (...) {
+            self.fail("unknown exception");
+        }
+        return -1;
+    }
+    static std::uint64_t run(void* handle, std::uint64_t cycles) {
+        auto& self = *static_cast<PluginInstance*>(handle);
+        std::uint64_t done = 0;
+        try {
+            // the hot loop: adapter and bench are fully inlined here
+            while (done < cycles && !self.finished()) {
+                self.adapter.cycle(self.bench);
+                ++done;
+            }
+        } catch (const std::exception& e) {
+            self.fail(e.what());
+        } catch (...) {
+            self.fail("unknown exception");
+        }
+        return done;
+    }
+    static std::uint64_t getCycles(void* handle) {
+        return static_cast<PluginInstance*>(handle)->bench.getCycles();
+    }
+    static int isFinished(void* handle) {
+        return static_cast<PluginInstance*>(handle)->finished() ? 1 : 0;
+    }
+    static int exitCode(void* handle) {
+        auto& self = *static_cast<PluginInstance*>(handle);
+        if (self.failed) {
+            return 1;
+        }
+        if constexpr (requires { self.adapter.exitCode(); }) {
+            return self.adapter.exitCode();
+        }
+        return 0;
+    }
+    static const char* lastError(void* handle) {
+        auto& self = *static_cast<PluginInstance*>(handle);
+        return self.failed ? self.error.c_str() : nullptr;
+    }
+};
+
+/**
+ * Function table of the plugin defined by VSC_DEFINE_MODEL_PLUGIN
+ */
+template <typename Bench, ModelPluginAdapter<Bench> Adapter>
+const VscModelPluginApi* modelPluginApi(const char* modelName) {
+    using Instance = PluginInstance<Bench, Adapter>;
+    static const VscModelPluginApi api = {
+        VSC_MODEL_PLUGIN_ABI_VERSION,
+        sizeof(VscModelPluginApi),
+        modelName,
+        &Instance::create,
+        &Instance::destroy,
+        &Instance::reset,
+        &Instance::run,
+        &Instance::getCycles,
+        &Instance::isFinished,
+        &Instance::exitCode,
+        &Instance::lastError,
+    };
+    return &api;
+}
+
+} // namespace internal
+
+} // namespace vsc
+
+/**
+ * Export the plugin entry point for a bench type and its adapter. Use once per shared
+ * object; pass type aliases for template types with several arguments.
+ */
+#define VSC_DEFINE_MODEL_PLUGIN(BenchType, AdapterType)                                  \
+    extern "C" __attribute__((visibility("default"))) const VscModelPluginApi*           \
+    vscModelPluginEntry() {                                                              \
+        return ::vsc::internal::modelPluginApi<BenchType, AdapterType>(#BenchType);      \
+    }
+
+#endif /* VSC_MODEL_PLUGIN_H_ */
@@ -0,0 +1,84 @@
+/** @file
+ * C interface between model plugins and the hosts that load them.
+ *
+ * Only plain C types cross the boundary, so a plugin may be built with a different
+ * compiler, standard library or set of VSC headers than the host, as long as the ABI
+ * version matches.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_PLUGIN_ABI_H_
+#define VSC_PLUGIN_ABI_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Bumped whenever VscModelPluginApi changes incompatibly.
+ */
+#define VSC_MODEL_PLUGIN_ABI_VERSION 1u
+/**
+ * Name of the function every plugin exports, see VscModelPluginEntry.
+ */
+#define VSC_MODEL_PLUGIN_ENTRY "vscModelPluginEntry"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Function table of one model plugin
+ *
+ * Instances are opaque handles created by create(). run() executes the whole cycle
+ * loop inside the plugin, so the host pays one indirect call per batch of cycles. Calls
+ * on one instance must not overlap; separate instances are independent.
+ *
+ * Functions that can fail report it through their return value; lastError() then
+ * describes the failure until the next call on that instance.
+ */
+typedef struct VscModelPluginApi {
+    uint32_t abiVersion; // VSC_MODEL_PLUGIN_ABI_VERSION of the plugin
+    uint32_t structSize; // sizeof(VscModelPluginApi) of the plugin
+    const char* modelName;
+
+    /**
+     * Create a model instance. The arguments are passed to the model's VerilatedContext
+     * and the adapter. Returns null on failure and writes the reason to error.
+     */
+    void* (*create)(int argc, const char* const* argv, char* error, size_t errorSize);
+    void (*destroy)(void* instance);
+    /**
+     * Reset the model. Returns 0 on success.
+     */
+    int (*reset)(void* instance);
+    /**
+     * Advance up to cycles cycles, stopping early once the adapter reports it finished
+     * or a cycle failed. Returns the number of cycles executed.
+     */
+    uint64_t (*run)(void* instance, uint64_t cycles);
+    /**
+     * Cycles since the last reset.
+     */
+    uint64_t (*getCycles)(void* instance);
+    /**
+     * Non-zero once the adapter finished or a call failed.
+     */
+    int (*finished)(void* instance);
+    /**
+     * Process exit code suggested by the adapter, non-zero after a failure.
+     */
+    int (*exitCode)(void* instance);
+    /**
+     * Description of the last failure, or null.
+     */
+    const char* (*lastError)(void* instance);
+} VscModelPluginApi;
+
+typedef const VscModelPluginApi* (*VscModelPluginEntry)(void);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif /* VSC_PLUGIN_ABI_H_ */
@@ -0,0 +1,82 @@
+/** @file
+ * Host side of the model plugin interface.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_PLUGIN_LOADER_H_
+#define VSC_PLUGIN_LOADER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "VSC/plugin/PluginAbi.h"
+
+namespace vsc {
+
+/**
+ * A model plugin shared object opened with dlopen
+ *
+ * Each plugin is opened with RTLD_LOCAL, so several plugins, each carrying its own
+ * copy of the Verilator runtime, can be loaded into one process. The library stays
+ * loaded until the PluginLibrary is destroyed, which must not happen before all of its
+ * PluginModels are gone.
+ */
+class PluginLibrary {
+private:
+    void* handle;
+    const VscModelPluginApi* api;
+    std::string path;
+
+public:
+    /**
+     * Open a plugin and check its ABI version. Throws std::runtime_error on failure.
+     */
+    explicit PluginLibrary(const std::string& path);
+    ~PluginLibrary();
+
+    const VscModelPluginApi& getApi() const { return *api; }
+    const char* getModelName() const { return api->modelName; }
+    const std::string& getPath() const { return path; }
+
+    PluginLibrary(const PluginLibrary& other) = delete;
+    PluginLibrary& operator=(const PluginLibrary& other) = delete;
+};
+
+/**
+ * One model instance created by a plugin
+ *
+ * Failures reported by the plugin are thrown as std::runtime_error.
+ */
+class PluginModel {
+private:
+    const VscModelPluginApi* api;
+    void* instance;
+
+    [[noreturn]] void throwLastError(const char* operation) const;
+
+public:
+    /**
+     * Create an instance; args are the model's command line without the program name.
+     */
+    PluginModel(const PluginLibrary& library, const std::vector<std::string>& args);
+    ~PluginModel();
+
+    void reset();
+    /**
+     * Run up to cycles cycles inside the plugin.
+     * @return the cycles executed, fewer than requested once the model finished
+     */
+    std::uint64_t run(std::uint64_t cycles);
+    std::uint64_t getCycles() const { return api->getCycles(instance); }
+    bool finished() const { return api->finished(instance) != 0; }
+    int exitCode() const { return api->exitCode(instance); }
+
+    PluginModel(const PluginModel& other) = delete;
+    PluginModel& operator=(const PluginModel& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_PLUGIN_LOADER_H_ */
@@ -0,0 +1,251 @@
+/** @file
+ * In-memory checkpoints of savable verilated models.
+ *
+ * Requires the model to be verilated with --savable.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_CHECKPOINT_H_
+#define VSC_CHECKPOINT_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+#include <verilated_save.h>
+
+#include "VSC/VerilatorBench.h"
+#include "VSC/util/Hash.h"
+
+namespace vsc {
+
+/**
+ * Savable verilated testbench constraint
+ *
+ * The model must be verilated with --savable so the generated stream operators exist.
+ */
+template <typename TopModule>
+concept SavableToplevel =
+    VerilatedToplevel<TopModule> &&
+    requires(TopModule& m, VerilatedSerialize& os, VerilatedDeserialize& is) {
+        os << m;
+        is >> m;
+    };
+
+/**
+ * A snapshot of a bench's model state and cycle count
+ *
+ * The state is held in the Verilator save format, so it contains no pointers and can be
+ * restored into any instance of the same model, including one owned by another thread.
+ * A checkpoint can be captured into repeatedly; the buffer is reused.
+ */
+class ModelCheckpoint {
+private:
+    unsigned long cycleCount = 0;
+    std::vector<std::uint8_t> state;
+
+public:
+    /**
+     * Capture the current state of a bench, replacing any previous contents.
+     */
+    template <SavableToplevel TopModule, BenchPolicy... Policies>
+    void capture(VerilatorBench<TopModule, Policies...>& bench);
+    /**
+     * Restore a bench to the captured state, including its cycle count.
+     */
+    template <SavableToplevel TopModule, BenchPolicy... Policies>
+    void restore(VerilatorBench<TopModule, Policies...>& bench) const;
+    /**
+     * Get the bench cycle count at capture time.
+     */
+    unsigned long getCycles() const { return cycleCount; }
+    /**
+     * Get the raw serialized model state.
+     */
+    std::span<const std::uint8_t> data() const { return state; }
+    bool empty() const { return state.empty(); }
+    /**
+     * Hash the serialized state, see stateHash(). It is independent of the model
+     * instance, which makes it the cheap way to check that a restore reproduces a run or
+     * that two workers reached the same state.
+     */
+    std::uint64_t hash() const { return hashBytes(std::as_bytes(data())); }
+    /**
+     * Write the checkpoint to a file. Throws std::runtime_error on I/O failure.
+     */
+    void writeFile(const std::string& path) const;
+    /**
+     * Read a checkpoint previously written by writeFile(). Throws std::runtime_error if
+     * the file cannot be opened or read, or does not hold a whole checkpoint.
+     */
+    static ModelCheckpoint readFile(const std::string& path);
+};
+
+/**
+ * Hash the full state of a bench's model.
+ *
+ * The model is serialized as for a checkpoint, so the hash covers every module instance
+ * (not only the root module), strings, queues and other heap-backed variables, and no
+ * pointers or padding. The result equals ModelCheckpoint::hash() of a checkpoint
+ * captured at the same point and is comparable across model instances. A StateHasher
+ * over selected signals is cheaper when only part of the state matters.
+ */
+template <SavableToplevel TopModule, BenchPolicy... Policies>
+std::uint64_t stateHash(VerilatorBench<TopModule, Policies...>& bench);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+namespace internal {
+
+/**
+ * Verilator serializer that appends to a byte vector instead of a file.
+ */
+class MemorySerialize final : public VerilatedSerialize {
+private:
+    std::vector<std::uint8_t>& out;
+
+public:
+    explicit MemorySerialize(std::vector<std::uint8_t>& out) : out(out) {
+        m_isOpen = true;
+        header();
+    }
+    ~MemorySerialize() override { close(); }
+    void close() override {
+        if (!isOpen()) {
+            return;
+        }
+        trailer();
+        flush();
+        m_isOpen = false;
+    }
+    void flush() override {
+        out.insert(out.end(), m_bufp, m_cp);
+        m_cp = m_bufp;
+    }
+};
+
+/**
+ * Verilator deserializer that reads from a byte span instead of a file.
+ */
+class MemoryDeserialize final : public VerilatedDeserialize {
+private:
+    const std::uint8_t* next;
+    const std::uint8_t* end;
+
+public:
+    explicit MemoryDeserialize(std::span<const std::uint8_t> in)
+        : next(in.data()), end(in.data() + in.size()) {
+        m_isOpen = true;
+        m_cp = m_bufp;
+        m_endp = m_bufp;
+        fill();
+        header();
+    }
+    ~MemoryDeserialize() override { close(); }
+    void close() override {
+        if (!isOpen()) {
+            return;
+        }
+        trailer();
+        m_isOpen = false;
+    }
+    void fill() override {
+        const std::size_t pending = static_cast<std::size_t>(m_endp - m_cp);
+        std::memmove(m_bufp, m_cp, pending);
+        m_cp = m_bufp;
+        m_endp = m_bufp + pending;
+        const std::size_t room = bufferSize() - pending;
+        const std::size_t count = std::min(room, static_cast<std::size_t>(end - next));
+        std::memcpy(m_endp, next, count);
+        m_endp += count;
+        next += count;
+    }
+};
+
+/**
+ * Hash the serialized state of a model, reusing a per-thread buffer.
+ */
+template <SavableToplevel TopModule> std::uint64_t serializedStateHash(TopModule& model) {
+    thread_local std::vector<std::uint8_t> buffer;
+    buffer.clear();
+    {
+        MemorySerialize os(buffer);
+        os << model;
+    }
+    return hashBytes(std::as_bytes(std::span<const std::uint8_t>(buffer)));
+}
+
+} // namespace internal
+
+template <SavableToplevel TopModule, BenchPolicy... Policies>
+std::uint64_t stateHash(VerilatorBench<TopModule, Policies...>& bench) {
+    return internal::serializedStateHash(*bench.topmodule);
+}
+
+// Begin ModelCheckpoint Implementations
+template <SavableToplevel TopModule, BenchPolicy... Policies>
+void ModelCheckpoint::capture(VerilatorBench<TopModule, Policies...>& bench) {
+    state.clear();
+    {
+        internal::MemorySerialize os(state);
+        os << *bench.topmodule;
+    }
+    cycleCount = bench.getCycles();
+}
+
+template <SavableToplevel TopModule, BenchPolicy... Policies>
+void ModelCheckpoint::restore(VerilatorBench<TopModule, Policies...>& bench) const {
+    {
+        internal::MemoryDeserialize is(state);
+        is >> *bench.topmodule;
+    }
+    bench.cycles = cycleCount;
+}
+
+inline void ModelCheckpoint::writeFile(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    const std::uint64_t header[2] = {cycleCount, state.size()};
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(state.data()),
+              static_cast<std::streamsize>(state.size()));
+    if (!out) {
+        throw std::runtime_error("failed writing checkpoint: " + path);
+    }
+}
+
+inline ModelCheckpoint ModelCheckpoint::readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("cannot open checkpoint: " + path);
+    }
+    const auto fileSize = static_cast<std::uint64_t>(in.tellg());
+    in.seekg(0);
+    std::uint64_t header[2] = {0, 0};
+    in.read(reinterpret_cast<char*>(header), sizeof(header));
+    // bound the state size by the file before allocating for it
+    if (!in || header[1] != fileSize - sizeof(header)) {
+        throw std::runtime_error("truncated or corrupt checkpoint: " + path);
+    }
+    ModelCheckpoint checkpoint;
+    checkpoint.cycleCount = static_cast<unsigned long>(header[0]);
+    checkpoint.state.resize(header[1]);
+    in.read(reinterpret_cast<char*>(checkpoint.state.data()),
+            static_cast<std::streamsize>(checkpoint.state.size()));
+    if (!in) {
+        throw std::runtime_error("failed reading checkpoint: " + path);
+    }
+    return checkpoint;
+}
+// End ModelCheckpoint Implementations
+
+} // namespace vsc
+
+#endif /* VSC_CHECKPOINT_H_ */
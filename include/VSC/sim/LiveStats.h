@@ -0,0 +1,118 @@
+/** @file
+ * Live bench statistics exported through shared memory.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_LIVE_STATS_H_
+#define VSC_LIVE_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace vsc {
+
+/**
+ * Layout of one shared-memory stats page
+ *
+ * Readers on other processes use the seqlock: sequence is odd while the writer is
+ * updating the counters, and a snapshot is only valid if sequence was even and
+ * unchanged across the read. A sequence of 0 means the page is still being set up. The
+ * header is written once before the first publish; the counters are lock-free atomics
+ * so the page can be read concurrently without data races.
+ */
+struct LiveStatsPage {
+    static constexpr std::uint64_t pageMagic = 0x3154415453435356; // "VSCSTAT1"
+    static constexpr std::size_t nameBytes = 64;
+
+    std::uint64_t magic;
+    std::int64_t pid;
+    char name[nameBytes];
+    std::int64_t startNs; // CLOCK_REALTIME at creation
+
+    std::atomic<std::uint64_t> sequence;
+    std::atomic<std::uint64_t> cycles;
+    std::atomic<std::uint64_t> transactions;
+    std::atomic<std::uint64_t> errors;
+    std::atomic<std::uint64_t> cyclesPerSecondBits; // double, bit-cast
+    std::atomic<std::int64_t> updateNs;             // CLOCK_REALTIME of the last publish
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+};
+
+/**
+ * A consistent copy of one bench's counters.
+ */
+struct LiveStatsSnapshot {
+    std::string name;
+    std::int64_t pid = 0;
+    bool alive = false; // owning process still exists
+    std::uint64_t cycles = 0;
+    std::uint64_t transactions = 0;
+    std::uint64_t errors = 0;
+    double cyclesPerSecond = 0.0;
+    double uptimeSeconds = 0.0;
+    double secondsSinceUpdate = 0.0;
+};
+
+/**
+ * Writes one bench's counters into a shared-memory page named /vsc-stats.<pid>.<n>
+ *
+ * Transactions and errors are counted in process memory and only copied into the page
+ * on publish, so the simulation loop pays a compare per cycle and a handful of stores
+ * per publish interval. The page is removed when the publisher is destroyed.
+ */
+class LiveStatsPublisher {
+private:
+    LiveStatsPage* page;
+    std::string shmName;
+    std::uint64_t interval;
+    std::uint64_t nextPublish;
+    std::uint64_t transactions;
+    std::uint64_t errors;
+    std::uint64_t lastCycles;
+    std::int64_t lastNs;
+
+public:
+    /**
+     * Create and map a new stats page. Throws std::runtime_error on failure.
+     * @param name label shown by vsc-top, truncated to 63 characters
+     * @param intervalCycles cycles between publishes in maybePublish()
+     */
+    explicit LiveStatsPublisher(const std::string& name,
+                                std::uint64_t intervalCycles = 65536);
+    ~LiveStatsPublisher();
+
+    void countTransaction(std::uint64_t count = 1) { transactions += count; }
+    void countError(std::uint64_t count = 1) { errors += count; }
+    /**
+     * Publish if at least intervalCycles passed since the last publish. Cheap enough to
+     * call every cycle, e.g. with bench.getCycles().
+     */
+    void maybePublish(std::uint64_t cycles) {
+        if (cycles >= nextPublish) {
+            publish(cycles);
+        }
+    }
+    /**
+     * Copy the counters into the page and update the cycle rate.
+     */
+    void publish(std::uint64_t cycles);
+    const std::string& getShmName() const { return shmName; }
+
+    // the page is owned by exactly one publisher
+    LiveStatsPublisher(const LiveStatsPublisher& other) = delete;
+    LiveStatsPublisher& operator=(const LiveStatsPublisher& other) = delete;
+};
+
+/**
+ * Read every stats page on the host, sorted by pid and name. Pages that cannot be read
+ * or are not stats pages are skipped.
+ */
+std::vector<LiveStatsSnapshot> readAllLiveStats();
+
+} // namespace vsc
+
+#endif /* VSC_LIVE_STATS_H_ */
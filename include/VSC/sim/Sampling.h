@@ -0,0 +1,241 @@
+/** @file
+ * Sampled simulation: fast-forward with short detailed measurement windows.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_SAMPLING_H_
+#define VSC_SAMPLING_H_
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "VSC/VerilatorBench.h"
+#include "VSC/sim/Checkpoint.h"
+
+namespace vsc {
+
+/**
+ * Sampling hooks constraint
+ *
+ * The hooks switch the bench between its fast-forward and detailed modes:
+ *   - enterDetailed(bench, window): enable monitors, stats and tracing
+ *   - beginMeasurement(bench, window): clear the per-window counters once warmup is
+ *     over
+ *   - detailedCycle(bench): advance one cycle with all handlers attached
+ *   - exitDetailed(bench, window) -> double: disable the detailed machinery and return
+ *     the window's measurement (e.g. IPC)
+ *   - fastForwardCycle(bench) (optional): advance one cycle cheaply; defaults to
+ *     advanceCycle() with no handlers
+ *   - finished(bench) (optional): true once the workload has completed
+ */
+template <typename Hooks, typename Bench>
+concept SamplingHooks = requires(Hooks& h, Bench& bench, std::size_t window) {
+    h.enterDetailed(bench, window);
+    h.beginMeasurement(bench, window);
+    h.detailedCycle(bench);
+    { h.exitDetailed(bench, window) } -> std::convertible_to<double>;
+};
+
+struct SamplingPlan {
+    std::uint64_t totalCycles = 0;  // workload length the samples are spread over
+    std::size_t windowCount = 0;    // number of detailed windows
+    std::uint64_t warmupCycles = 0; // detailed cycles before each measured window
+    std::uint64_t windowCycles = 0; // measured cycles per window
+    bool randomOffset = true;       // random start within each period, else period start
+    std::uint64_t seed = 0;         // seed for the random offsets
+    // explicit window start cycles, overrides the even spread above when non-empty
+    std::vector<std::uint64_t> windowStarts;
+    std::string checkpointDirectory; // save a checkpoint at each window start if set,
+                                     // savable models only
+    bool runToCompletion = false;    // keep fast-forwarding after the last window
+};
+
+struct WindowSample {
+    std::size_t window = 0;
+    std::uint64_t startCycle = 0; // cycle at which warmup began
+    double value = 0.0;
+};
+
+struct SamplingResult {
+    std::vector<WindowSample> samples;
+    double mean = 0.0;
+    double stddev = 0.0;
+    // half-width of the 95% confidence interval of the mean, from the Student t
+    // distribution since sampled runs rarely use more than a few dozen windows
+    double confidence95 = 0.0;
+    std::uint64_t simulatedCycles = 0;
+};
+
+/**
+ * Run a workload in sampled mode.
+ *
+ * The bench fast-forwards to each window start, then runs warmupCycles detailed but
+ * unmeasured cycles, followed by windowCycles measured cycles. By default the windows
+ * are spread evenly over totalCycles (systematic sampling) with a random start inside
+ * each period. Saved checkpoints (savable models only) let a window be re-examined
+ * later in full detail without replaying the fast-forward.
+ * @param bench bench to drive, already reset and loaded with the workload
+ * @param hooks mode switching and measurement callbacks
+ * @param plan window placement
+ * @throws std::invalid_argument if the plan asks for more evenly spread windows than
+ *         totalCycles, or for checkpoints of a model not verilated with --savable
+ */
+template <VerilatedToplevel TopModule, BenchPolicy... Policies,
+          SamplingHooks<VerilatorBench<TopModule, Policies...>> Hooks>
+SamplingResult runSampled(VerilatorBench<TopModule, Policies...>& bench, Hooks& hooks,
+                          const SamplingPlan& plan);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+namespace internal {
+
+/**
+ * Two-sided 95% Student t quantile t(0.975, degrees). Between table entries the value
+ * of the next lower tabulated degree is used, which errs on the wide side; 1.96 is the
+ * large sample limit.
+ */
+inline double studentT975(std::size_t degrees) {
+    static constexpr std::array<double, 30> table = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (degrees == 0) {
+        return 0.0;
+    }
+    if (degrees <= table.size()) {
+        return table[degrees - 1];
+    }
+    if (degrees < 40) {
+        return table.back();
+    }
+    if (degrees < 60) {
+        return 2.021;
+    }
+    if (degrees < 120) {
+        return 2.000;
+    }
+    return degrees < 1000 ? 1.980 : 1.960;
+}
+
+inline std::vector<std::uint64_t> windowStartCycles(const SamplingPlan& plan) {
+    if (!plan.windowStarts.empty()) {
+        std::vector<std::uint64_t> starts = plan.windowStarts;
+        std::sort(starts.begin(), starts.end());
+        return starts;
+    }
+    std::vector<std::uint64_t> starts;
+    if (plan.windowCount == 0) {
+        return starts;
+    }
+    const std::uint64_t period = plan.totalCycles / plan.windowCount;
+    if (period == 0) {
+        throw std::invalid_argument("sampling plan has more windows than cycles");
+    }
+    const std::uint64_t span = plan.warmupCycles + plan.windowCycles;
+    const std::uint64_t slack = period > span ? period - span : 0;
+    std::mt19937_64 rng(plan.seed);
+    for (std::size_t i = 0; i < plan.windowCount; ++i) {
+        const std::uint64_t offset =
+            plan.randomOffset && slack > 0
+                ? std::uniform_int_distribution<std::uint64_t>(0, slack)(rng)
+                : 0;
+        starts.push_back(i * period + offset);
+    }
+    return starts;
+}
+
+} // namespace internal
+
+template <VerilatedToplevel TopModule, BenchPolicy... Policies,
+          SamplingHooks<VerilatorBench<TopModule, Policies...>> Hooks>
+SamplingResult runSampled(VerilatorBench<TopModule, Policies...>& bench, Hooks& hooks,
+                          const SamplingPlan& plan) {
+    if constexpr (!SavableToplevel<TopModule>) {
+        if (!plan.checkpointDirectory.empty()) {
+            throw std::invalid_argument(
+                "window checkpoints need a model verilated with --savable");
+        }
+    }
+    SamplingResult result;
+    const std::uint64_t begin = bench.getCycles();
+    auto elapsed = [&] { return bench.getCycles() - begin; };
+    auto finished = [&] {
+        if constexpr (requires { hooks.finished(bench); }) {
+            return static_cast<bool>(hooks.finished(bench));
+        } else {
+            return false;
+        }
+    };
+    auto fastForwardTo = [&](std::uint64_t target) {
+        while (elapsed() < target && !finished()) {
+            if constexpr (requires { hooks.fastForwardCycle(bench); }) {
+                hooks.fastForwardCycle(bench);
+            } else {
+                bench.advanceCycle();
+            }
+        }
+    };
+
+    const std::vector<std::uint64_t> starts = internal::windowStartCycles(plan);
+    for (std::size_t window = 0; window < starts.size(); ++window) {
+        // overlapping explicit windows start as soon as the previous one ends
+        fastForwardTo(starts[window]);
+        if (finished()) {
+            break;
+        }
+        if constexpr (SavableToplevel<TopModule>) {
+            if (!plan.checkpointDirectory.empty()) {
+                ModelCheckpoint checkpoint;
+                checkpoint.capture(bench);
+                checkpoint.writeFile(plan.checkpointDirectory + "/window" +
+                                     std::to_string(window) + ".ckpt");
+            }
+        }
+
+        const std::uint64_t windowStart = elapsed();
+        hooks.enterDetailed(bench, window);
+        for (std::uint64_t i = 0; i < plan.warmupCycles; ++i) {
+            hooks.detailedCycle(bench);
+        }
+        hooks.beginMeasurement(bench, window);
+        for (std::uint64_t i = 0; i < plan.windowCycles; ++i) {
+            hooks.detailedCycle(bench);
+        }
+        const double value = hooks.exitDetailed(bench, window);
+        result.samples.push_back({window, windowStart, value});
+    }
+    if (plan.runToCompletion) {
+        fastForwardTo(plan.totalCycles);
+    }
+    result.simulatedCycles = elapsed();
+
+    const double n = static_cast<double>(result.samples.size());
+    if (n > 0) {
+        for (const WindowSample& sample : result.samples) {
+            result.mean += sample.value / n;
+        }
+    }
+    if (n > 1) {
+        double squares = 0.0;
+        for (const WindowSample& sample : result.samples) {
+            squares += (sample.value - result.mean) * (sample.value - result.mean);
+        }
+        result.stddev = std::sqrt(squares / (n - 1));
+        result.confidence95 = internal::studentT975(result.samples.size() - 1) *
+                              result.stddev / std::sqrt(n);
+    }
+    return result;
+}
+
+} // namespace vsc
+
+#endif /* VSC_SAMPLING_H_ */
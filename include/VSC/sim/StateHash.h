@@ -0,0 +1,106 @@
+/** @file
+ * Model state hashing for convergence checks and state deduplication.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_STATE_HASH_H_
+#define VSC_STATE_HASH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VSC/util/Hash.h"
+
+namespace vsc {
+
+/**
+ * Incremental hash over a set of model memory regions
+ *
+ * Regions are typically the backing storage of selected signals and memories, reached
+ * through the model's rootp. Each region's hash is cached, so when the caller knows only
+ * some regions changed (e.g. a memory written by a transactor) only those are rehashed
+ * before the combined digest is taken.
+ *
+ * Regions hold raw pointers into one model instance. Region contents hash the same in
+ * every instance, so digests of signal regions can be compared across instances.
+ */
+class StateHasher {
+private:
+    struct Region {
+        std::string name;
+        std::span<const std::byte> bytes;
+        std::uint64_t hash;
+    };
+    std::vector<Region> regions;
+
+public:
+    /**
+     * Add a region and hash it.
+     * @return region index for refresh()
+     */
+    std::size_t addRegion(std::string name, std::span<const std::byte> bytes);
+    /**
+     * Convenience overload for a single model variable or array.
+     */
+    template <typename T> std::size_t addVariable(std::string name, const T& variable);
+    /**
+     * Rehash one region after its contents changed.
+     */
+    void refresh(std::size_t region);
+    /**
+     * Rehash all regions.
+     */
+    void refreshAll();
+    /**
+     * Get the cached hash of one region.
+     */
+    std::uint64_t regionHash(std::size_t region) const { return regions[region].hash; }
+    /**
+     * Combine the cached region hashes into a single digest.
+     */
+    std::uint64_t digest() const;
+    std::size_t size() const { return regions.size(); }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+// Begin StateHasher Implementations
+inline std::size_t StateHasher::addRegion(std::string name,
+                                          std::span<const std::byte> bytes) {
+    regions.push_back({std::move(name), bytes, hashBytes(bytes)});
+    return regions.size() - 1;
+}
+
+template <typename T>
+std::size_t StateHasher::addVariable(std::string name, const T& variable) {
+    return addRegion(std::move(name), std::as_bytes(std::span<const T, 1>(&variable, 1)));
+}
+
+inline void StateHasher::refresh(std::size_t region) {
+    regions[region].hash = hashBytes(regions[region].bytes);
+}
+
+inline void StateHasher::refreshAll() {
+    for (Region& region : regions) {
+        region.hash = hashBytes(region.bytes);
+    }
+}
+
+inline std::uint64_t StateHasher::digest() const {
+    std::uint64_t result = regions.size();
+    for (const Region& region : regions) {
+        result = hashCombine(result, region.hash);
+    }
+    return result;
+}
+// End StateHasher Implementations
+
+} // namespace vsc
+
+#endif /* VSC_STATE_HASH_H_ */
@@ -0,0 +1,215 @@
+/** @file
+ * Time-sliced parallel re-simulation of one long run from checkpoints.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_TIME_SLICE_H_
+#define VSC_TIME_SLICE_H_
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "VSC/sim/Checkpoint.h"
+#include "VSC/util/Parallel.h"
+
+namespace vsc {
+
+/**
+ * Time-slice hooks constraint
+ *
+ * The hooks are copied once per slice, so monitors and collectors held in them start
+ * empty for every slice:
+ *   - runSlice(bench, slice, cycles) -> R: simulate the given number of cycles with full
+ *     monitoring from the restored slice start and return what was collected
+ *   - fastForwardCycle(bench) (optional): advance one cycle during the checkpointing
+ *     pass; defaults to advanceCycle() with no handlers
+ * State kept outside the verilated model (e.g. C++ memory models) is not part of the
+ * checkpoints, so runSlice must rebuild it for the slice start if the design uses any.
+ */
+template <typename Hooks, typename Bench>
+concept TimeSliceHooks =
+    std::copy_constructible<Hooks> &&
+    requires(Hooks& h, Bench& bench, std::size_t slice, std::uint64_t cycles) {
+        { h.runSlice(bench, slice, cycles) };
+        requires !std::is_void_v<decltype(h.runSlice(bench, slice, cycles))>;
+    };
+
+template <typename Hooks, typename Bench>
+using SliceResultOf = std::decay_t<decltype(std::declval<Hooks&>().runSlice(
+    std::declval<Bench&>(), std::size_t{}, std::uint64_t{}))>;
+
+struct TimeSliceOptions {
+    std::uint64_t totalCycles = 0; // length of the whole run
+    std::uint64_t sliceCycles = 0; // cycles per slice
+    unsigned workers = 0;          // slice workers, 0 = all cores
+};
+
+template <typename R> struct TimeSliceResult {
+    std::vector<R> slices; // slice results in simulation order, ready to be stitched
+    // slices whose detailed run did not end in the state the checkpointing pass
+    // recorded, i.e. where the stitched result differs from a serial detailed run
+    std::vector<std::size_t> divergentSlices;
+};
+
+/**
+ * Simulate one long run as parallel slices.
+ *
+ * The calling thread fast-forwards the bench through the run, capturing a checkpoint
+ * at every slice boundary. Worker threads pick up each slice as soon as its starting
+ * checkpoint exists, restore it into their own model and run it with full monitoring,
+ * so the detailed work overlaps the checkpointing pass and the wall-clock time
+ * approaches the fast-forward time plus one slice.
+ *
+ * Every slice's end state is hashed and compared with the next boundary checkpoint. A
+ * mismatch means the monitoring perturbed the design (or the design is
+ * nondeterministic) and the slice is reported as divergent.
+ *
+ * Each worker simulates on its own bench with the same policies, default constructed.
+ * @param bench bench to fast-forward, already reset and loaded with the workload
+ * @param hooks slice simulation callbacks, copied per slice
+ * @param options run length, slice length and worker count
+ */
+template <SavableToplevel TopModule, BenchPolicy... Policies,
+          TimeSliceHooks<VerilatorBench<TopModule, Policies...>> Hooks>
+TimeSliceResult<SliceResultOf<Hooks, VerilatorBench<TopModule, Policies...>>>
+runTimeSliced(VerilatorBench<TopModule, Policies...>& bench, const Hooks& hooks,
+              const TimeSliceOptions& options);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+template <SavableToplevel TopModule, BenchPolicy... Policies,
+          TimeSliceHooks<VerilatorBench<TopModule, Policies...>> Hooks>
+TimeSliceResult<SliceResultOf<Hooks, VerilatorBench<TopModule, Policies...>>>
+runTimeSliced(VerilatorBench<TopModule, Policies...>& bench, const Hooks& hooks,
+              const TimeSliceOptions& options) {
+    const std::uint64_t sliceCycles = std::max<std::uint64_t>(options.sliceCycles, 1);
+    const std::size_t sliceCount =
+        static_cast<std::size_t>((options.totalCycles + sliceCycles - 1) / sliceCycles);
+    const unsigned workerCount =
+        options.workers == 0 ? defaultWorkerCount() : options.workers;
+
+    using Bench = VerilatorBench<TopModule, Policies...>;
+    TimeSliceResult<SliceResultOf<Hooks, Bench>> result;
+    result.slices.resize(sliceCount);
+    std::vector<std::unique_ptr<ModelCheckpoint>> starts(sliceCount);
+    std::vector<std::uint64_t> startHashes(sliceCount + 1, 0);
+    std::vector<std::uint64_t> endHashes(sliceCount, 0);
+
+    std::mutex lock;
+    std::condition_variable sliceReady;
+    std::size_t published = 0; // slices whose start checkpoint exists
+    std::size_t claimed = 0;   // slices taken by a worker
+    bool aborted = false;
+    std::exception_ptr firstError;
+
+    auto runWorker = [&] {
+        VerilatedContext context;
+        Bench sliceBench(&context);
+        while (true) {
+            std::size_t slice;
+            std::unique_ptr<ModelCheckpoint> start;
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                sliceReady.wait(guard, [&] {
+                    return aborted || claimed < published || claimed == sliceCount;
+                });
+                if (aborted || claimed == sliceCount) {
+                    return;
+                }
+                slice = claimed++;
+                start = std::move(starts[slice]);
+            }
+            try {
+                start->restore(sliceBench);
+                start.reset(); // the checkpoint is no longer needed, free it early
+                const std::uint64_t first = slice * sliceCycles;
+                const std::uint64_t cycles =
+                    std::min(sliceCycles, options.totalCycles - first);
+                Hooks sliceHooks(hooks);
+                result.slices[slice] = sliceHooks.runSlice(sliceBench, slice, cycles);
+                ModelCheckpoint end;
+                end.capture(sliceBench);
+                endHashes[slice] = end.hash();
+            } catch (...) {
+                std::lock_guard<std::mutex> guard(lock);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+                aborted = true;
+                sliceReady.notify_all();
+                return;
+            }
+        }
+    };
+
+    {
+        std::vector<std::jthread> workers;
+        try {
+            for (unsigned w = 0; w < workerCount; ++w) {
+                workers.emplace_back(runWorker);
+            }
+
+            // checkpointing pass on the calling thread
+            Hooks forward(hooks);
+            for (std::size_t slice = 0; slice <= sliceCount; ++slice) {
+                auto checkpoint = std::make_unique<ModelCheckpoint>();
+                checkpoint->capture(bench);
+                {
+                    std::lock_guard<std::mutex> guard(lock);
+                    startHashes[slice] = checkpoint->hash();
+                    if (slice == sliceCount || aborted) {
+                        break;
+                    }
+                    starts[slice] = std::move(checkpoint);
+                    ++published;
+                }
+                sliceReady.notify_one();
+
+                const std::uint64_t cycles =
+                    std::min(sliceCycles, options.totalCycles - slice * sliceCycles);
+                for (std::uint64_t i = 0; i < cycles; ++i) {
+                    if constexpr (requires { forward.fastForwardCycle(bench); }) {
+                        forward.fastForwardCycle(bench);
+                    } else {
+                        bench.advanceCycle();
+                    }
+                }
+            }
+        } catch (...) {
+            // release the workers waiting for slices that will never be published,
+            // otherwise joining them below never returns
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                aborted = true;
+            }
+            sliceReady.notify_all();
+            throw;
+        }
+        // wake idle workers so they see that no further slices will be published
+        sliceReady.notify_all();
+    }
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+
+    for (std::size_t slice = 0; slice < sliceCount; ++slice) {
+        if (endHashes[slice] != startHashes[slice + 1]) {
+            result.divergentSlices.push_back(slice);
+        }
+    }
+    return result;
+}
+
+} // namespace vsc
+
+#endif /* VSC_TIME_SLICE_H_ */
@@ -0,0 +1,45 @@
+/** @file
+ * Phases of one VerilatorBench cycle, as seen by bench policies.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_BENCH_PHASE_H_
+#define VSC_BENCH_PHASE_H_
+
+#include <cstddef>
+
+namespace vsc {
+
+/**
+ * Phases of VerilatorBench::advanceCycle(), in execution order
+ */
+enum class BenchPhase { Settle, EvalRise, RiseHandler, EvalFall, FallHandler };
+inline constexpr std::size_t benchPhaseCount = 5;
+
+constexpr const char* benchPhaseName(BenchPhase phase) {
+    switch (phase) {
+        case BenchPhase::Settle:
+            return "eval settle";
+        case BenchPhase::EvalRise:
+            return "eval rise";
+        case BenchPhase::RiseHandler:
+            return "rise handler";
+        case BenchPhase::EvalFall:
+            return "eval fall";
+        case BenchPhase::FallHandler:
+            return "fall handler";
+    }
+    return "unknown";
+}
+
+/**
+ * Check whether a phase evaluates the model, as opposed to running a user handler.
+ */
+constexpr bool isEvalPhase(BenchPhase phase) {
+    return phase != BenchPhase::RiseHandler && phase != BenchPhase::FallHandler;
+}
+
+} // namespace vsc
+
+#endif /* VSC_BENCH_PHASE_H_ */
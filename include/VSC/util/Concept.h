@@ -24,12 +24,10 @@ concept ResourceCreator = requires(CreatorFun f, Args&&... args) {
 /**
  * Clock edge handler callable constraint
  *
- * A valid function must have the signature void handler(VerilatedModel &m)
+ * A valid function must have the signature void handler(VerilatedModel* m)
  */
 template <typename ClkEdgeFun, typename VerilatedModel>
-concept ClkEdgeHandler = requires(ClkEdgeFun f, VerilatedModel vm) {
-    { f } -> std::convertible_to<std::function<void(VerilatedModel&)>>;
-};
+concept ClkEdgeHandler = std::invocable<ClkEdgeFun&, VerilatedModel*>;
 
 /**
  * Verilated testbench constraint
@@ -42,9 +40,27 @@ concept VerilatedToplevel = requires(TopModule m) {
     { m.clk } -> std::convertible_to<int>;
     { m.rst } -> std::convertible_to<int>;
     m.eval_step();
-    m.end_eval_step();
+    m.eval_end_step();
 };
 
+/**
+ * Verilated model constraint for designs without the clk/rst convention
+ *
+ * Only requires the model to be evaluable, as is the case for purely combinational
+ * blocks.
+ */
+template <typename Model>
+concept EvaluableModel = requires(Model m) { m.eval(); };
+
+/**
+ * VerilatorBench instrumentation policy constraint
+ *
+ * Policies are default constructed together with the bench and configured through
+ * VerilatorBench::policy() afterwards. All hooks are optional.
+ */
+template <typename Policy>
+concept BenchPolicy = std::default_initializable<Policy>;
+
 } // namespace vsc
 
 #endif /* VSC_CONCEPT_H_ */
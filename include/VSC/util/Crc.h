@@ -0,0 +1,128 @@
+/** @file
+ * Table-driven and hardware-accelerated CRC computation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_CRC_H_
+#define VSC_CRC_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace vsc {
+
+/**
+ * CRC parameters in the usual catalogue form
+ *
+ * Input and output are either both reflected (least significant bit first, as on
+ * Ethernet and USB) or both not (most significant bit first, as on SD).
+ */
+struct CrcParams {
+    unsigned width;       // 1 to 32 bits
+    std::uint32_t poly;   // normal form, without the x^width term
+    std::uint32_t init;   // register value before the first bit, not reflected
+    bool reflected;
+    std::uint32_t xorOut; // applied to the final register value
+};
+
+inline constexpr CrcParams crc32Ieee{32, 0x04c11db7, 0xffffffff, true, 0xffffffff};
+inline constexpr CrcParams crc32c{32, 0x1edc6f41, 0xffffffff, true, 0xffffffff};
+inline constexpr CrcParams crc16Xmodem{16, 0x1021, 0x0000, false, 0x0000}; // SD data
+inline constexpr CrcParams crc16Usb{16, 0x8005, 0xffff, true, 0xffff};
+inline constexpr CrcParams crc8Smbus{8, 0x07, 0x00, false, 0x00};
+inline constexpr CrcParams crc7Mmc{7, 0x09, 0x00, false, 0x00}; // SD commands
+inline constexpr CrcParams crc5Usb{5, 0x05, 0x1f, true, 0x1f};
+
+/**
+ * CRC engine for one parameter set
+ *
+ * Generic parameters use slicing-by-8 tables, eight bytes per step. On x86-64 the CPU is
+ * checked once at construction: CRC-32C uses the SSE4.2 crc32 instruction and CRC-32
+ * (IEEE 802.3) folds 64 bytes per step with carry-less multiplication (PCLMULQDQ), the
+ * tables only handling the tail. All implementations give the same results.
+ *
+ * The engine is immutable after construction and can be shared between threads.
+ * Streams keep their own state, see CrcStream:
+ *   std::uint32_t state = crc.begin();
+ *   state = crc.update(state, header);
+ *   state = crc.update(state, payload);
+ *   const std::uint32_t fcs = crc.finish(state);
+ */
+class Crc {
+private:
+    enum class Kernel { Table, Sse42, Pclmul };
+
+    CrcParams params;
+    unsigned shift; // most significant bit first registers are kept in the top bits
+    Kernel kernel;
+    std::array<std::array<std::uint32_t, 256>, 8> tables;
+
+    std::uint32_t updateTable(std::uint32_t state, const std::uint8_t* data,
+                              std::size_t size) const;
+
+public:
+    /**
+     * @param accelerate use CPU instructions when available
+     */
+    explicit Crc(const CrcParams& params, bool accelerate = true);
+
+    const CrcParams& getParams() const { return params; }
+    /**
+     * Name of the implementation in use, e.g. for benchmark reports.
+     */
+    const char* getImplementation() const;
+
+    /**
+     * Register state before any data.
+     */
+    std::uint32_t begin() const;
+    /**
+     * Continue a state with more data.
+     */
+    std::uint32_t update(std::uint32_t state, std::span<const std::uint8_t> data) const;
+    /**
+     * Turn a state into the CRC value.
+     */
+    std::uint32_t finish(std::uint32_t state) const;
+    std::uint32_t compute(std::span<const std::uint8_t> data) const {
+        return finish(update(begin(), data));
+    }
+};
+
+/**
+ * Running CRC of one stream, e.g. a packet collected by a monitor
+ */
+class CrcStream {
+private:
+    const Crc& crc;
+    std::uint32_t state;
+
+public:
+    explicit CrcStream(const Crc& crc) : crc{crc}, state{crc.begin()} {}
+
+    void reset() { state = crc.begin(); }
+    void update(std::span<const std::uint8_t> data) { state = crc.update(state, data); }
+    void update(std::uint8_t byte) { state = crc.update(state, {&byte, 1}); }
+    std::uint32_t value() const { return crc.finish(state); }
+};
+
+/**
+ * Shared engine for a parameter set with static storage duration, built on first use,
+ * e.g. crcFor<crc32Ieee>().compute(frame).
+ */
+template <const CrcParams& Params> const Crc& crcFor();
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+template <const CrcParams& Params> const Crc& crcFor() {
+    static const Crc engine(Params);
+    return engine;
+}
+
+} // namespace vsc
+
+#endif /* VSC_CRC_H_ */
@@ -0,0 +1,166 @@
+/** @file
+ * Fast non-cryptographic hashing of large memory regions.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_HASH_H_
+#define VSC_HASH_H_
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace vsc {
+
+/**
+ * Hash a block of memory to 64 bits.
+ *
+ * The bulk loop consumes 64-byte stripes into eight independent 64-bit accumulators
+ * using 32x32->64 multiplies (the XXH3 accumulation scheme), which maps directly onto
+ * SSE2/AVX2 lanes. The vector and scalar paths compute the same value, so hashes are
+ * portable between builds. Not suitable where collision resistance against an adversary
+ * matters.
+ * @param data bytes to hash
+ * @param seed value mixed into the initial state, to derive independent hash functions
+ */
+std::uint64_t hashBytes(std::span<const std::byte> data, std::uint64_t seed = 0);
+
+/**
+ * Combine two hashes in an order-dependent way.
+ */
+constexpr std::uint64_t hashCombine(std::uint64_t lhs, std::uint64_t rhs);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+namespace internal {
+
+inline constexpr std::uint64_t hashPrime1 = 0x9E3779B185EBCA87ULL;
+inline constexpr std::uint64_t hashPrime2 = 0xC2B2AE3D27D4EB4FULL;
+inline constexpr std::uint64_t hashPrime3 = 0x165667B19E3779F9ULL;
+inline constexpr std::uint64_t hashPrime4 = 0x85EBCA77C2B2AE63ULL;
+inline constexpr std::uint64_t hashPrime5 = 0x27D4EB2F165667C5ULL;
+inline constexpr std::uint32_t hashPrime32 = 0x9E3779B1U;
+
+alignas(64) inline constexpr std::uint64_t hashSecret[8] = {
+    0xBE4BA423396CFEB8ULL, 0x1CAD21F72C81017CULL, 0xDB979083E96DD4DEULL,
+    0x1F67B3B7A4A44072ULL, 0x78E5C0CC4EE679CBULL, 0x2172FFCC7DD05A82ULL,
+    0x8E2443F7744608B8ULL, 0x4C263A81E69035E0ULL,
+};
+
+constexpr std::size_t hashStripeBytes = 64;
+constexpr std::size_t hashStripesPerBlock = 16;
+
+inline std::uint64_t hashLoad64(const std::byte* p) {
+    std::uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) {
+        value = __builtin_bswap64(value);
+    }
+    return value;
+}
+
+inline void hashStripe(std::uint64_t* __restrict acc, const std::byte* __restrict p) {
+#if defined(__AVX2__)
+    const __m256i* secret = reinterpret_cast<const __m256i*>(hashSecret);
+    __m256i* lanes = reinterpret_cast<__m256i*>(acc);
+    for (int i = 0; i < 2; ++i) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p) + i);
+        const __m256i keyed = _mm256_xor_si256(data, _mm256_load_si256(secret + i));
+        const __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+        const __m256i swapped = _mm256_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        const __m256i sum = _mm256_add_epi64(_mm256_loadu_si256(lanes + i), swapped);
+        _mm256_storeu_si256(lanes + i, _mm256_add_epi64(sum, product));
+    }
+#elif defined(__SSE2__)
+    const __m128i* secret = reinterpret_cast<const __m128i*>(hashSecret);
+    __m128i* lanes = reinterpret_cast<__m128i*>(acc);
+    for (int i = 0; i < 4; ++i) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p) + i);
+        const __m128i keyed = _mm_xor_si128(data, _mm_load_si128(secret + i));
+        const __m128i product = _mm_mul_epu32(keyed, _mm_srli_epi64(keyed, 32));
+        const __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        const __m128i sum = _mm_add_epi64(_mm_loadu_si128(lanes + i), swapped);
+        _mm_storeu_si128(lanes + i, _mm_add_epi64(sum, product));
+    }
+#else
+    for (int i = 0; i < 8; ++i) {
+        const std::uint64_t data = hashLoad64(p + 8 * i);
+        const std::uint64_t keyed = data ^ hashSecret[i];
+        acc[i ^ 1] += data;
+        acc[i] += (keyed & 0xFFFFFFFFULL) * (keyed >> 32);
+    }
+#endif
+}
+
+inline void hashScramble(std::uint64_t* acc) {
+    for (int i = 0; i < 8; ++i) {
+        acc[i] = (acc[i] ^ (acc[i] >> 47) ^ hashSecret[i]) * hashPrime32;
+    }
+}
+
+constexpr std::uint64_t hashAvalanche(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= hashPrime2;
+    h ^= h >> 29;
+    h *= hashPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // namespace internal
+
+inline std::uint64_t hashBytes(std::span<const std::byte> data, std::uint64_t seed) {
+    using namespace internal;
+    alignas(32) std::uint64_t acc[8] = {
+        hashPrime32, hashPrime1, hashPrime2, hashPrime3,
+        hashPrime4,  hashPrime5, hashPrime1 ^ hashPrime4, hashPrime2 ^ hashPrime5,
+    };
+    for (std::uint64_t& lane : acc) {
+        lane ^= seed;
+    }
+
+    const std::byte* p = data.data();
+    std::size_t remaining = data.size();
+    constexpr std::size_t blockBytes = hashStripeBytes * hashStripesPerBlock;
+    while (remaining >= blockBytes) {
+        for (std::size_t s = 0; s < hashStripesPerBlock; ++s) {
+            hashStripe(acc, p + s * hashStripeBytes);
+        }
+        hashScramble(acc);
+        p += blockBytes;
+        remaining -= blockBytes;
+    }
+    while (remaining >= hashStripeBytes) {
+        hashStripe(acc, p);
+        p += hashStripeBytes;
+        remaining -= hashStripeBytes;
+    }
+    if (remaining != 0) {
+        std::byte tail[hashStripeBytes] = {};
+        std::memcpy(tail, p, remaining);
+        hashStripe(acc, tail);
+    }
+
+    std::uint64_t h = data.size() * hashPrime1 ^ seed;
+    for (std::uint64_t lane : acc) {
+        h ^= hashAvalanche(lane);
+        h = std::rotl(h, 27) * hashPrime1 + hashPrime4;
+    }
+    return hashAvalanche(h);
+}
+
+constexpr std::uint64_t hashCombine(std::uint64_t lhs, std::uint64_t rhs) {
+    return internal::hashAvalanche(std::rotl(lhs, 31) * internal::hashPrime1 ^ rhs);
+}
+
+} // namespace vsc
+
+#endif /* VSC_HASH_H_ */
@@ -0,0 +1,150 @@
+/** @file
+ * Work-stealing parallel loop used by the multi-run simulation drivers.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_PARALLEL_H_
+#define VSC_PARALLEL_H_
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vsc {
+
+/**
+ * Get the number of workers to use when the caller does not specify one.
+ */
+unsigned defaultWorkerCount();
+
+/**
+ * Run task(index, worker) for every index in [0, count) across a set of worker threads.
+ *
+ * Indices are dealt round-robin to per-worker queues, so each worker starts on the
+ * front of the index space and submission order is (roughly) execution order. A worker
+ * whose queue runs dry steals the back half of another worker's queue. This keeps all
+ * cores busy when task runtimes are uneven, which is the normal case for simulation
+ * runs.
+ *
+ * The worker index passed to the task is stable for the lifetime of the thread and is
+ * in [0, workers), so callers can keep one model instance per worker. The calling thread
+ * acts as worker 0. If a task throws, remaining tasks are abandoned and the first
+ * exception is rethrown once all workers have stopped.
+ * @param count number of task indices
+ * @param workers number of worker threads to use (including the calling thread)
+ * @param task callable invoked as task(std::size_t index, unsigned worker)
+ */
+template <typename TaskFun>
+void parallelFor(std::size_t count, unsigned workers, TaskFun&& task);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+inline unsigned defaultWorkerCount() {
+    const unsigned hwThreads = std::thread::hardware_concurrency();
+    return hwThreads == 0 ? 1 : hwThreads;
+}
+
+namespace internal {
+
+struct alignas(64) WorkQueue {
+    std::mutex lock;
+    std::deque<std::size_t> tasks;
+};
+
+inline bool popOwnTask(WorkQueue& queue, std::size_t& index) {
+    std::lock_guard<std::mutex> guard(queue.lock);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    index = queue.tasks.front();
+    queue.tasks.pop_front();
+    return true;
+}
+
+inline bool stealTasks(std::vector<WorkQueue>& queues, unsigned self) {
+    std::vector<std::size_t> stolen;
+    for (unsigned offset = 1; offset < queues.size() && stolen.empty(); ++offset) {
+        WorkQueue& victim = queues[(self + offset) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        const std::size_t take = (victim.tasks.size() + 1) / 2;
+        for (std::size_t i = 0; i < take; ++i) {
+            stolen.push_back(victim.tasks.back());
+            victim.tasks.pop_back();
+        }
+    }
+    if (stolen.empty()) {
+        return false;
+    }
+    std::lock_guard<std::mutex> guard(queues[self].lock);
+    // stolen holds the victim's tail in reverse, restore ascending order
+    queues[self].tasks.insert(queues[self].tasks.end(), stolen.rbegin(), stolen.rend());
+    return true;
+}
+
+} // namespace internal
+
+template <typename TaskFun>
+void parallelFor(std::size_t count, unsigned workers, TaskFun&& task) {
+    if (workers == 0) {
+        workers = defaultWorkerCount();
+    }
+    if (workers > count) {
+        workers = static_cast<unsigned>(count);
+    }
+    if (workers <= 1) {
+        for (std::size_t i = 0; i < count; ++i) {
+            task(i, 0u);
+        }
+        return;
+    }
+
+    std::vector<internal::WorkQueue> queues(workers);
+    for (std::size_t i = 0; i < count; ++i) {
+        queues[i % workers].tasks.push_back(i);
+    }
+
+    std::atomic<bool> aborted{false};
+    std::exception_ptr firstError;
+    std::mutex errorLock;
+    auto runWorker = [&](unsigned self) {
+        try {
+            std::size_t index;
+            while (!aborted.load(std::memory_order_relaxed)) {
+                if (internal::popOwnTask(queues[self], index)) {
+                    task(index, self);
+                } else if (!internal::stealTasks(queues, self)) {
+                    // every queue is drained; tasks held by thieves are run by them
+                    break;
+                }
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(errorLock);
+            if (!firstError) {
+                firstError = std::current_exception();
+            }
+            aborted.store(true, std::memory_order_relaxed);
+        }
+    };
+
+    {
+        std::vector<std::jthread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; ++w) {
+            threads.emplace_back(runWorker, w);
+        }
+        runWorker(0);
+    } // join workers
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
+} // namespace vsc
+
+#endif /* VSC_PARALLEL_H_ */
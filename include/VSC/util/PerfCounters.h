@@ -0,0 +1,104 @@
+/** @file
+ * Hardware performance counters aggregated per bench phase.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_PERF_COUNTERS_H_
+#define VSC_PERF_COUNTERS_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "VSC/util/BenchPhase.h"
+
+namespace vsc {
+
+enum class PerfEvent { Instructions, Cycles, CacheMisses, BranchMisses };
+inline constexpr std::size_t perfEventCount = 4;
+
+const char* perfEventName(PerfEvent event);
+
+using PerfValues = std::array<std::uint64_t, perfEventCount>;
+
+/**
+ * Counter totals normalized to simulated cycles.
+ */
+struct PhaseCounterReport {
+    std::uint64_t measuredCycles = 0; // simulated cycles that were measured
+    std::array<bool, perfEventCount> available{};
+    bool multiplexed = false; // the kernel time-shared the counters; totals are partial
+    std::uint64_t droppedSamples = 0; // phase measurements lost to failed counter reads
+    // perCycle[phase][event]: event count per measured simulated cycle
+    std::array<std::array<double, perfEventCount>, benchPhaseCount> perCycle{};
+
+    /**
+     * Render as a table with IPC and misses per thousand instructions per phase.
+     */
+    std::string format() const;
+};
+
+/**
+ * perf_event_open counter group for the calling thread
+ *
+ * Instructions, cycles, cache misses and branch misses are opened as one group so they
+ * are read together with a single syscall. User space only, which also works under
+ * perf_event_paranoid=2. Events the kernel or hardware refuse are left out; the
+ * counters must be read on the thread that created them.
+ *
+ * Every measured phase reads the group on entry and exit, so measuring every cycle adds
+ * around ten syscalls per cycle. Set sampleEvery to measure only every Nth simulated
+ * cycle and keep the perturbation small on long runs. A phase whose entry or exit read
+ * fails is left out of the totals and counted as a dropped sample.
+ */
+class PhaseCounters {
+private:
+    std::array<int, perfEventCount> fds;
+    std::array<int, perfEventCount> slot; // position in the group read, -1 = missing
+    int leader;
+    std::size_t opened;
+    std::uint64_t sampleEvery;
+    std::uint64_t countdown;
+    std::uint64_t measuredCycles;
+    bool multiplexed;
+    std::uint64_t droppedSamples;
+    PerfValues entry;
+    bool entryValid;
+    std::array<PerfValues, benchPhaseCount> totals;
+
+    bool readGroup(PerfValues& values);
+
+public:
+    explicit PhaseCounters(std::uint64_t sampleEvery = 1);
+    ~PhaseCounters();
+
+    /**
+     * True if at least one event could be opened.
+     */
+    bool available() const { return opened > 0; }
+    /**
+     * Called at the start of every simulated cycle.
+     * @return whether the phases of this cycle should be measured
+     */
+    bool beginCycle() {
+        if (opened == 0 || --countdown != 0) {
+            return false;
+        }
+        countdown = sampleEvery;
+        ++measuredCycles;
+        return true;
+    }
+    void enterPhase() { entryValid = readGroup(entry); }
+    void leavePhase(BenchPhase phase);
+    void reset();
+    PhaseCounterReport report() const;
+
+    PhaseCounters(const PhaseCounters& other) = delete;
+    PhaseCounters& operator=(const PhaseCounters& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_PERF_COUNTERS_H_ */
@@ -0,0 +1,104 @@
+/** @file
+ * Span tracing into per-thread buffers with Chrome trace JSON export.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_TRACE_H_
+#define VSC_TRACE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace vsc {
+
+/**
+ * One recorded trace event. Names and categories are not copied, so they must have
+ * static storage duration (string literals).
+ */
+struct TraceEvent {
+    const char* name;
+    const char* category;
+    std::int64_t startNs;
+    std::int64_t durationNs;
+    char phase;   // Chrome trace phase: 'X' span, 'i' instant, 'C' counter
+    double value; // counter value
+};
+
+namespace internal {
+
+extern std::atomic<bool> tracingEnabled;
+
+std::int64_t traceClockNs();
+void recordTraceEvent(const TraceEvent& event);
+
+} // namespace internal
+
+/**
+ * Check whether tracing is currently recording. A single relaxed load.
+ */
+inline bool isTracing() {
+    return internal::tracingEnabled.load(std::memory_order_relaxed);
+}
+/**
+ * Start recording. Each thread buffers at most maxEventsPerThread events; further
+ * events are dropped and counted, so a forgotten trace cannot exhaust memory.
+ */
+void startTracing(std::size_t maxEventsPerThread = std::size_t{1} << 20);
+/**
+ * Stop recording. Recorded events are kept until clearTrace().
+ */
+void stopTracing();
+/**
+ * Discard all recorded events. Events of exited threads are kept for export until then.
+ */
+void clearTrace();
+/**
+ * Name the calling thread in exported traces (e.g. "sim", "ui", "uart rx").
+ */
+void setTraceThreadName(std::string name);
+/**
+ * Record a zero-length marker on the calling thread.
+ */
+void traceInstant(const char* name, const char* category = "vsc");
+/**
+ * Record a counter sample, shown as a graph track in the trace viewer.
+ */
+void traceCounter(const char* name, double value);
+/**
+ * Write every thread's events as Chrome trace JSON, loadable by chrome://tracing and
+ * ui.perfetto.dev. Throws std::runtime_error on I/O failure.
+ */
+void writeChromeTrace(const std::string& path);
+
+/**
+ * RAII span covering the lifetime of the object
+ *
+ * When tracing is off, construction and destruction cost one relaxed load each.
+ */
+class TraceSpan {
+private:
+    const char* name;
+    const char* category;
+    std::int64_t startNs; // negative when tracing was off at construction
+
+public:
+    explicit TraceSpan(const char* name, const char* category = "vsc")
+        : name{name}, category{category},
+          startNs{isTracing() ? internal::traceClockNs() : -1} {}
+    ~TraceSpan() {
+        if (startNs >= 0) {
+            internal::recordTraceEvent(
+                {name, category, startNs, internal::traceClockNs() - startNs, 'X', 0.0});
+        }
+    }
+
+    TraceSpan(const TraceSpan& other) = delete;
+    TraceSpan& operator=(const TraceSpan& other) = delete;
+};
+
+} // namespace vsc
+
+#endif /* VSC_TRACE_H_ */
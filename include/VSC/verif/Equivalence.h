@@ -0,0 +1,144 @@
+/** @file
+ * Lockstep equivalence checking between two verilated models.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_EQUIVALENCE_H_
+#define VSC_EQUIVALENCE_H_
+
+#include <concepts>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <verilated.h>
+
+#include "VSC/VerilatorBench.h"
+#include "VSC/util/Parallel.h"
+
+namespace vsc {
+
+/**
+ * Equivalence harness constraint
+ *
+ * The harness generates one stimulus per cycle and knows how to apply it to, and read the
+ * outputs from, both model types. Since the two models usually share port names, apply
+ * and outputs are typically generic lambdas or templated members. Each job works on its
+ * own copy of the harness.
+ *   - begin(seed, shard): prepare the stimulus source for one job (e.g. seed an RNG or
+ *     seek into a stimulus file)
+ *   - stimulus(cycle): produce the stimulus for the cycle about to be simulated
+ *   - apply(m, stim): drive a stimulus onto either model
+ *   - outputs(m): observable outputs of either model; the two must compare with ==
+ *   - describe(a, b) (optional): human readable account of a divergence
+ */
+template <typename Harness, typename TopA, typename TopB>
+concept EquivalenceHarness =
+    std::copy_constructible<Harness> &&
+    requires(Harness& h, std::uint64_t seed, std::uint64_t shard, std::uint64_t cycle,
+             TopA* a, TopB* b) {
+        h.begin(seed, shard);
+        h.apply(a, h.stimulus(cycle));
+        h.apply(b, h.stimulus(cycle));
+        { h.outputs(a) == h.outputs(b) } -> std::convertible_to<bool>;
+    };
+
+struct EquivalenceOptions {
+    std::uint64_t cycles = 0; // cycles simulated per shard after reset
+    std::uint64_t shards = 1; // stimulus shards per seed
+    unsigned workers = 0;     // 0 = all cores
+    bool reuseModels = false; // reset instead of rebuilding the models between jobs
+};
+
+struct EquivalenceResult {
+    std::uint64_t seed = 0;
+    std::uint64_t shard = 0;
+    bool diverged = false;
+    std::uint64_t divergentCycle = 0; // first cycle (after reset) with differing outputs
+    std::string description;          // from the harness' describe(), if it has one
+};
+
+/**
+ * Drive two models with identical stimulus in lockstep and compare their outputs.
+ *
+ * Every (seed, shard) pair is an independent job: both models are reset, the harness is
+ * prepared with begin(seed, shard), and the models are advanced together for up to
+ * options.cycles cycles. The outputs are compared after every cycle and a job stops at
+ * its first divergence. Jobs run on the work-stealing parallelFor, each worker owning one
+ * bench per side with its own VerilatedContext.
+ * @param seeds stimulus seeds to check
+ * @param harness stimulus generation and output comparison, copied per job
+ * @param options cycle budget, sharding and scheduling parameters
+ * @return one result per job, ordered by seed then shard
+ */
+template <VerilatedToplevel TopA, VerilatedToplevel TopB,
+          EquivalenceHarness<TopA, TopB> Harness>
+std::vector<EquivalenceResult> runEquivalence(std::span<const std::uint64_t> seeds,
+                                              const Harness& harness,
+                                              const EquivalenceOptions& options);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+namespace internal {
+
+template <VerilatedToplevel TopA, VerilatedToplevel TopB> struct EquivalencePair {
+    VerilatedContext contextA;
+    VerilatedContext contextB;
+    VerilatorBench<TopA> benchA{&contextA};
+    VerilatorBench<TopB> benchB{&contextB};
+};
+
+} // namespace internal
+
+template <VerilatedToplevel TopA, VerilatedToplevel TopB,
+          EquivalenceHarness<TopA, TopB> Harness>
+std::vector<EquivalenceResult> runEquivalence(std::span<const std::uint64_t> seeds,
+                                              const Harness& harness,
+                                              const EquivalenceOptions& options) {
+    using Pair = internal::EquivalencePair<TopA, TopB>;
+    const unsigned workerCount =
+        options.workers == 0 ? defaultWorkerCount() : options.workers;
+    std::vector<std::unique_ptr<Pair>> pairs(workerCount);
+    std::vector<EquivalenceResult> results(seeds.size() * options.shards);
+
+    parallelFor(results.size(), workerCount, [&](std::size_t index, unsigned self) {
+        if (!pairs[self] || !options.reuseModels) {
+            pairs[self].reset(); // release the old models before building new ones
+            pairs[self] = std::make_unique<Pair>();
+        }
+        VerilatorBench<TopA>& a = pairs[self]->benchA;
+        VerilatorBench<TopB>& b = pairs[self]->benchB;
+        EquivalenceResult& result = results[index];
+        result.seed = seeds[index / options.shards];
+        result.shard = index % options.shards;
+
+        Harness job(harness);
+        a.reset();
+        b.reset();
+        job.begin(result.seed, result.shard);
+        for (std::uint64_t cycle = 0; cycle < options.cycles; ++cycle) {
+            const auto& stimulus = job.stimulus(cycle);
+            job.apply(a.topmodule, stimulus);
+            job.apply(b.topmodule, stimulus);
+            a.advanceCycle();
+            b.advanceCycle();
+            if (!(job.outputs(a.topmodule) == job.outputs(b.topmodule))) {
+                result.diverged = true;
+                result.divergentCycle = cycle;
+                if constexpr (requires { job.describe(a.topmodule, b.topmodule); }) {
+                    result.description = job.describe(a.topmodule, b.topmodule);
+                }
+                return;
+            }
+        }
+    });
+    return results;
+}
+
+} // namespace vsc
+
+#endif /* VSC_EQUIVALENCE_H_ */
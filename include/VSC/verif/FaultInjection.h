@@ -0,0 +1,338 @@
+/** @file
+ * Parallel single-bit fault-injection campaigns.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_FAULT_INJECTION_H_
+#define VSC_FAULT_INJECTION_H_
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VSC/sim/Checkpoint.h"
+#include "VSC/util/Parallel.h"
+
+namespace vsc {
+
+/**
+ * A storage element that faults can be injected into
+ *
+ * The locate function returns the bytes backing the element in a given model instance,
+ * either a public signal (--public-flat-rw) or a member reached through the model's
+ * rootp (backdoor access). Verilator pads signals to their C type, so the element is
+ * described as elementCount elements of elementWidth meaningful bits each, with the
+ * located bytes split evenly between elements.
+ */
+template <typename TopModule> struct FaultTarget {
+    std::string name;
+    std::function<std::span<std::byte>(TopModule*)> locate;
+    unsigned elementWidth = 0;
+    std::size_t elementCount = 1;
+
+    std::size_t bitCount() const { return elementWidth * elementCount; }
+};
+
+/**
+ * A single-event upset: flip one bit of a target right before a cycle is simulated.
+ */
+struct Fault {
+    std::size_t target = 0; // index into the campaign's target list
+    std::size_t bit = 0;    // bit index in [0, target.bitCount())
+    std::uint64_t cycle = 0; // campaign cycle (from the start checkpoint) to inject at
+};
+
+enum class FaultOutcome {
+    Masked,           // the faulty state re-converged to golden without visible effect
+    Detected,         // the design flagged the error
+    SilentCorruption, // outputs diverged from golden without detection
+    Latent,           // state still differs at the end of the window, outputs unaffected
+};
+
+struct FaultResult {
+    FaultOutcome outcome = FaultOutcome::Masked;
+    std::uint64_t decidedCycle = 0; // campaign cycle at which the outcome was decided
+};
+
+/**
+ * Fault campaign probe constraint
+ *
+ * The probe defines how the design is observed during a campaign. Each worker gets its
+ * own copy, so probes may hold per-worker scratch state.
+ *   - drive(m, cycle): apply stimulus for the cycle about to be simulated
+ *   - outputs(m): digest of the observable outputs after a cycle
+ *   - detected(m): true if the design's error detection has fired
+ *   - stateDigest(m) (optional): digest of the state used for convergence checks. The
+ *     golden digests are recorded once and compared on every worker's model, so it must
+ *     not depend on the instance (e.g. hash signal values, not addresses). Without it
+ *     the full model state hash (stateHash()) is used.
+ */
+template <typename Probe, typename TopModule>
+concept FaultProbe = std::copy_constructible<Probe> &&
+                     requires(Probe& p, TopModule* m, std::uint64_t cycle) {
+                         p.drive(m, cycle);
+                         { p.outputs(m) } -> std::convertible_to<std::uint64_t>;
+                         { p.detected(m) } -> std::convertible_to<bool>;
+                     };
+
+struct FaultCampaignOptions {
+    std::uint64_t cycles = 0;                // length of the observation window
+    std::uint64_t checkpointInterval = 4096; // golden checkpoint spacing in cycles
+    std::uint64_t convergenceInterval = 64;  // state digest compare spacing in cycles
+    unsigned workers = 0;                    // 0 = all cores
+};
+
+/**
+ * Tally of campaign outcomes, indexed by FaultOutcome.
+ */
+struct FaultCampaignSummary {
+    std::array<std::size_t, 4> counts{};
+
+    std::size_t count(FaultOutcome outcome) const {
+        return counts[static_cast<std::size_t>(outcome)];
+    }
+    static FaultCampaignSummary of(std::span<const FaultResult> results);
+};
+
+/**
+ * Run a fault-injection campaign.
+ *
+ * A golden run from the start checkpoint records checkpoints every checkpointInterval
+ * cycles. Faults are then distributed over the workers; each fault restores the nearest
+ * golden checkpoint before its injection cycle, flips the bit and runs until the outcome
+ * is known. Outputs and detection are checked every cycle, the state digest every
+ * convergenceInterval cycles; a run whose state matches golden again is classified as
+ * masked and stopped early.
+ *
+ * The golden run also records the reference outputs, detection flags and digests, which
+ * every worker then shares read-only. Each worker owns one model built with its own
+ * VerilatedContext.
+ * @param start checkpoint the campaign starts from
+ * @param targets storage elements faults refer to
+ * @param faults faults to inject, one run each
+ * @param probe observation hooks, copied per worker
+ * @param options window length and scheduling parameters
+ * @return one result per fault, in the order of the faults span
+ * @throws std::invalid_argument if the window length or an interval is zero
+ * @throws std::out_of_range if a fault lies outside its target or the window
+ */
+template <SavableToplevel TopModule, FaultProbe<TopModule> Probe>
+std::vector<FaultResult>
+runFaultCampaign(const ModelCheckpoint& start,
+                 std::span<const FaultTarget<TopModule>> targets,
+                 std::span<const Fault> faults, const Probe& probe,
+                 const FaultCampaignOptions& options);
+
+/**
+ * Draw faults uniformly over all target bits and campaign cycles. Throws
+ * std::invalid_argument if the targets have no bits or cycles is zero.
+ */
+template <typename TopModule>
+std::vector<Fault> randomFaults(std::span<const FaultTarget<TopModule>> targets,
+                                std::size_t count, std::uint64_t cycles,
+                                std::uint64_t seed);
+
+/**
+ * Get the bytes backing a model variable, for use in FaultTarget::locate.
+ */
+template <typename T> std::span<std::byte> storageOf(T& variable) {
+    return std::as_writable_bytes(std::span<T, 1>(&variable, 1));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+namespace internal {
+
+/**
+ * Reference behaviour of the fault-free design over the campaign window.
+ */
+struct FaultGolden {
+    std::vector<ModelCheckpoint> checkpoints; // per checkpoint interval
+    std::vector<std::uint64_t> outputs;       // per cycle
+    std::vector<bool> detected;               // per cycle
+    std::vector<std::uint64_t> digests;       // per convergence interval
+    std::uint64_t finalDigest = 0;
+};
+
+/**
+ * Model instance and probe owned by one worker.
+ */
+template <SavableToplevel TopModule, typename Probe> struct FaultWorker {
+    VerilatedContext context;
+    VerilatorBench<TopModule> bench;
+    Probe probe;
+
+    explicit FaultWorker(const Probe& probe) : bench(&context), probe(probe) {}
+
+    std::uint64_t stateDigest() {
+        if constexpr (requires { probe.stateDigest(bench.topmodule); }) {
+            return probe.stateDigest(bench.topmodule);
+        } else {
+            return stateHash(bench);
+        }
+    }
+
+    FaultGolden recordGolden(const ModelCheckpoint& start,
+                             const FaultCampaignOptions& options) {
+        FaultGolden golden;
+        start.restore(bench);
+        golden.outputs.resize(options.cycles);
+        golden.detected.resize(options.cycles);
+        golden.digests.assign(options.cycles / options.convergenceInterval + 1, 0);
+        golden.digests[0] = stateDigest();
+        for (std::uint64_t cycle = 0; cycle < options.cycles; ++cycle) {
+            if (cycle % options.checkpointInterval == 0) {
+                golden.checkpoints.emplace_back().capture(bench);
+            }
+            probe.drive(bench.topmodule, cycle);
+            bench.advanceCycle();
+            golden.outputs[cycle] = probe.outputs(bench.topmodule);
+            golden.detected[cycle] = probe.detected(bench.topmodule);
+            if ((cycle + 1) % options.convergenceInterval == 0) {
+                golden.digests[(cycle + 1) / options.convergenceInterval] = stateDigest();
+            }
+        }
+        golden.finalDigest = stateDigest();
+        return golden;
+    }
+};
+
+template <typename TopModule>
+void flipBit(const FaultTarget<TopModule>& target, TopModule* model, std::size_t bit) {
+    std::span<std::byte> bytes = target.locate(model);
+    const std::size_t stride = bytes.size() / target.elementCount;
+    const std::size_t element = bit / target.elementWidth;
+    const std::size_t offset = bit % target.elementWidth;
+    bytes[element * stride + offset / 8] ^= std::byte{1} << (offset % 8);
+}
+
+} // namespace internal
+
+template <SavableToplevel TopModule, FaultProbe<TopModule> Probe>
+std::vector<FaultResult>
+runFaultCampaign(const ModelCheckpoint& start,
+                 std::span<const FaultTarget<TopModule>> targets,
+                 std::span<const Fault> faults, const Probe& probe,
+                 const FaultCampaignOptions& options) {
+    using Worker = internal::FaultWorker<TopModule, Probe>;
+    if (options.cycles == 0 || options.checkpointInterval == 0 ||
+        options.convergenceInterval == 0) {
+        throw std::invalid_argument(
+            "fault campaign window and intervals must be at least one cycle");
+    }
+    for (const Fault& fault : faults) {
+        if (fault.cycle >= options.cycles) {
+            throw std::out_of_range("fault injection cycle outside campaign window");
+        }
+        if (fault.target >= targets.size() ||
+            fault.bit >= targets[fault.target].bitCount()) {
+            throw std::out_of_range("fault injection bit outside its target");
+        }
+    }
+    const unsigned workerCount =
+        options.workers == 0 ? defaultWorkerCount() : options.workers;
+
+    // one golden run serves every worker: checkpoints are pointer-free and digests
+    // instance independent; the calling thread is worker 0 and keeps the model
+    std::vector<std::unique_ptr<Worker>> workers(workerCount);
+    workers[0] = std::make_unique<Worker>(probe);
+    const internal::FaultGolden golden = workers[0]->recordGolden(start, options);
+
+    std::vector<FaultResult> results(faults.size());
+    parallelFor(faults.size(), workerCount, [&](std::size_t index, unsigned self) {
+        if (!workers[self]) {
+            workers[self] = std::make_unique<Worker>(probe);
+        }
+        Worker& worker = *workers[self];
+        const Fault& fault = faults[index];
+        FaultResult& result = results[index];
+
+        // fast-forward to the injection point from the closest golden checkpoint
+        const std::size_t checkpoint = fault.cycle / options.checkpointInterval;
+        golden.checkpoints[checkpoint].restore(worker.bench);
+        std::uint64_t cycle = fault.cycle - fault.cycle % options.checkpointInterval;
+        for (; cycle < fault.cycle; ++cycle) {
+            worker.probe.drive(worker.bench.topmodule, cycle);
+            worker.bench.advanceCycle();
+        }
+        internal::flipBit(targets[fault.target], worker.bench.topmodule, fault.bit);
+
+        for (; cycle < options.cycles; ++cycle) {
+            worker.probe.drive(worker.bench.topmodule, cycle);
+            worker.bench.advanceCycle();
+            if (worker.probe.detected(worker.bench.topmodule) &&
+                !golden.detected[cycle]) {
+                result = {FaultOutcome::Detected, cycle + 1};
+                return;
+            }
+            if (worker.probe.outputs(worker.bench.topmodule) != golden.outputs[cycle]) {
+                result = {FaultOutcome::SilentCorruption, cycle + 1};
+                return;
+            }
+            const std::uint64_t elapsed = cycle + 1;
+            if (elapsed % options.convergenceInterval == 0 &&
+                worker.stateDigest() ==
+                    golden.digests[elapsed / options.convergenceInterval]) {
+                result = {FaultOutcome::Masked, cycle + 1};
+                return;
+            }
+        }
+        const bool converged = worker.stateDigest() == golden.finalDigest;
+        result = {converged ? FaultOutcome::Masked : FaultOutcome::Latent,
+                  options.cycles};
+    });
+    return results;
+}
+
+template <typename TopModule>
+std::vector<Fault> randomFaults(std::span<const FaultTarget<TopModule>> targets,
+                                std::size_t count, std::uint64_t cycles,
+                                std::uint64_t seed) {
+    std::vector<std::size_t> bitOffsets; // cumulative bit counts for target selection
+    std::size_t totalBits = 0;
+    for (const FaultTarget<TopModule>& target : targets) {
+        bitOffsets.push_back(totalBits);
+        totalBits += target.bitCount();
+    }
+    if (totalBits == 0 || cycles == 0) {
+        throw std::invalid_argument("random faults need target bits and campaign cycles");
+    }
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<std::size_t> pickBit(0, totalBits - 1);
+    std::uniform_int_distribution<std::uint64_t> pickCycle(0, cycles - 1);
+    std::vector<Fault> faults(count);
+    for (Fault& fault : faults) {
+        const std::size_t bit = pickBit(rng);
+        const auto next = std::upper_bound(bitOffsets.begin(), bitOffsets.end(), bit);
+        fault.target = static_cast<std::size_t>(next - bitOffsets.begin()) - 1;
+        fault.bit = bit - bitOffsets[fault.target];
+        fault.cycle = pickCycle(rng);
+    }
+    return faults;
+}
+
+inline FaultCampaignSummary
+FaultCampaignSummary::of(std::span<const FaultResult> results) {
+    FaultCampaignSummary summary;
+    for (const FaultResult& result : results) {
+        ++summary.counts[static_cast<std::size_t>(result.outcome)];
+    }
+    return summary;
+}
+
+} // namespace vsc
+
+#endif /* VSC_FAULT_INJECTION_H_ */
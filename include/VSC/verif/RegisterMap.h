@@ -0,0 +1,273 @@
+/** @file
+ * Device register maps resolved at compile time.
+ *
+ * A device is described by constexpr tables:
+ *
+ *   inline constexpr vsc::RegisterField uartCtrlFields[] = {
+ *       {"EN", 0},
+ *       {"BAUD_DIV", 8, 16},
+ *   };
+ *   inline constexpr vsc::RegisterDef uartRegisters[] = {
+ *       {"CTRL", 0x00, uartCtrlFields},
+ *       {"STATUS", 0x04, {}, 32, vsc::RegisterAccess::ReadOnly},
+ *       {"TXDATA", 0x08, {}, 8, vsc::RegisterAccess::WriteOnly},
+ *   };
+ *   using UartMap = vsc::RegisterMap<uartRegisters>;
+ *
+ *   vsc::RegisterBlock<UartMap, AxiLiteMaster> uart(axi, 0x4000'0000);
+ *   uart.writeField<"CTRL", "BAUD_DIV">(434);
+ *   while (uart.read<"STATUS">() & 1) { ... }
+ *
+ * Names are looked up while compiling, so an access costs exactly the bus transaction
+ * with a constant address and mask. Misspelled names, overlapping fields and accesses
+ * against a register's direction are compile errors.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_REGISTER_MAP_H_
+#define VSC_REGISTER_MAP_H_
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace vsc {
+
+/**
+ * String literal usable as a template argument, e.g. read<"CTRL">()
+ */
+template <std::size_t N> struct FixedString {
+    char chars[N] = {};
+
+    consteval FixedString(const char (&text)[N]) { std::copy_n(text, N, chars); }
+    constexpr std::string_view view() const { return {chars, N - 1}; }
+};
+
+enum class RegisterAccess { ReadWrite, ReadOnly, WriteOnly };
+
+struct RegisterField {
+    std::string_view name;
+    unsigned lsb = 0;
+    unsigned width = 1; // in bits
+
+    constexpr std::uint64_t mask() const {
+        return (width >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1) << lsb;
+    }
+};
+
+struct RegisterDef {
+    std::string_view name;
+    std::uint64_t offset = 0; // from the device base address
+    std::span<const RegisterField> fields = {};
+    unsigned width = 32; // in bits
+    RegisterAccess access = RegisterAccess::ReadWrite;
+
+    constexpr std::uint64_t mask() const {
+        return width >= 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << width) - 1;
+    }
+};
+
+/**
+ * Register or field reference with everything resolved to numbers
+ */
+struct ResolvedRegister {
+    std::uint64_t offset;
+    std::uint64_t mask; // bits of the register, or of the field in place
+    unsigned shift;     // position of the field, 0 for whole registers
+    RegisterAccess access;
+};
+
+/**
+ * Device register bus constraint
+ *
+ * Implemented by bus transactors (e.g. an AXI-Lite or APB master driving the model) and
+ * by backdoors such as BackdoorBus. Addresses are absolute byte addresses.
+ */
+template <typename Bus>
+concept RegisterBus = requires(Bus& bus, std::uint64_t address, std::uint64_t value) {
+    { bus.read(address) } -> std::convertible_to<std::uint64_t>;
+    bus.write(address, value);
+};
+
+/**
+ * Compile-time view of a register table
+ *
+ * The table is validated when the map is first used: names must be unique, registers
+ * must not share an offset and fields must fit their register without overlapping.
+ * @tparam Registers a constexpr array of RegisterDef with static storage duration
+ */
+template <const auto& Registers> class RegisterMap {
+private:
+    static consteval bool isValid();
+    static consteval const RegisterDef& find(std::string_view name);
+    static consteval const RegisterField& findField(const RegisterDef& reg,
+                                                    std::string_view name);
+
+    static_assert(isValid(), "invalid register map: duplicate names or offsets, or "
+                             "fields outside their register or overlapping");
+
+public:
+    static constexpr std::span<const RegisterDef> registers{Registers};
+
+    template <FixedString Name> static constexpr ResolvedRegister reg = [] {
+        const RegisterDef& def = find(Name.view());
+        return ResolvedRegister{def.offset, def.mask(), 0, def.access};
+    }();
+    template <FixedString Reg, FixedString Field>
+    static constexpr ResolvedRegister field = [] {
+        const RegisterDef& def = find(Reg.view());
+        const RegisterField& bits = findField(def, Field.view());
+        return ResolvedRegister{def.offset, bits.mask(), bits.lsb, def.access};
+    }();
+};
+
+/**
+ * One device instance at a base address, accessed through a bus
+ * @tparam Map the device's RegisterMap
+ * @tparam Bus bus transactor or backdoor, see RegisterBus
+ */
+template <typename Map, RegisterBus Bus> class RegisterBlock {
+private:
+    Bus& bus;
+    std::uint64_t base;
+
+public:
+    explicit RegisterBlock(Bus& bus, std::uint64_t base = 0) : bus{bus}, base{base} {}
+
+    std::uint64_t getBase() const { return base; }
+
+    template <FixedString Name> std::uint64_t read();
+    template <FixedString Name> void write(std::uint64_t value);
+    /**
+     * Read a field, shifted down to bit 0.
+     */
+    template <FixedString Reg, FixedString Field> std::uint64_t readField();
+    /**
+     * Read-modify-write one field, leaving the other bits of the register unchanged.
+     */
+    template <FixedString Reg, FixedString Field> void writeField(std::uint64_t value);
+};
+
+/**
+ * Register bus over an array in the model, e.g. a register file reached through rootp
+ *
+ * Each array element backs one register of sizeof(Word) bytes starting at base.
+ */
+template <std::unsigned_integral Word> class BackdoorBus {
+private:
+    std::span<Word> words;
+    std::uint64_t base;
+
+public:
+    explicit BackdoorBus(std::span<Word> words, std::uint64_t base = 0)
+        : words{words},
+          base{base} {}
+
+    std::uint64_t read(std::uint64_t address) const {
+        return words[(address - base) / sizeof(Word)];
+    }
+    void write(std::uint64_t address, std::uint64_t value) {
+        words[(address - base) / sizeof(Word)] = static_cast<Word>(value);
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+// Begin RegisterMap Implementations
+template <const auto& Registers> consteval bool RegisterMap<Registers>::isValid() {
+    for (std::size_t i = 0; i < std::size(Registers); ++i) {
+        const RegisterDef& reg = Registers[i];
+        if (reg.width == 0 || reg.width > 64) {
+            return false;
+        }
+        for (std::size_t j = 0; j < i; ++j) {
+            if (Registers[j].name == reg.name || Registers[j].offset == reg.offset) {
+                return false;
+            }
+        }
+        std::uint64_t used = 0;
+        for (std::size_t f = 0; f < reg.fields.size(); ++f) {
+            const RegisterField& field = reg.fields[f];
+            if (field.width == 0 || field.lsb + field.width > reg.width ||
+                (used & field.mask()) != 0) {
+                return false;
+            }
+            used |= field.mask();
+            for (std::size_t g = 0; g < f; ++g) {
+                if (reg.fields[g].name == field.name) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+template <const auto& Registers>
+consteval const RegisterDef& RegisterMap<Registers>::find(std::string_view name) {
+    for (const RegisterDef& reg : Registers) {
+        if (reg.name == name) {
+            return reg;
+        }
+    }
+    throw "no register with this name in the map"; // not a constant expression
+}
+
+template <const auto& Registers>
+consteval const RegisterField& RegisterMap<Registers>::findField(const RegisterDef& reg,
+                                                                 std::string_view name) {
+    for (const RegisterField& field : reg.fields) {
+        if (field.name == name) {
+            return field;
+        }
+    }
+    throw "no field with this name in the register"; // not a constant expression
+}
+// End RegisterMap Implementations
+
+// Begin RegisterBlock Implementations
+template <typename Map, RegisterBus Bus>
+template <FixedString Name>
+std::uint64_t RegisterBlock<Map, Bus>::read() {
+    constexpr ResolvedRegister reg = Map::template reg<Name>;
+    static_assert(reg.access != RegisterAccess::WriteOnly, "register is write-only");
+    return static_cast<std::uint64_t>(bus.read(base + reg.offset)) & reg.mask;
+}
+
+template <typename Map, RegisterBus Bus>
+template <FixedString Name>
+void RegisterBlock<Map, Bus>::write(std::uint64_t value) {
+    constexpr ResolvedRegister reg = Map::template reg<Name>;
+    static_assert(reg.access != RegisterAccess::ReadOnly, "register is read-only");
+    bus.write(base + reg.offset, value & reg.mask);
+}
+
+template <typename Map, RegisterBus Bus>
+template <FixedString Reg, FixedString Field>
+std::uint64_t RegisterBlock<Map, Bus>::readField() {
+    constexpr ResolvedRegister field = Map::template field<Reg, Field>;
+    static_assert(field.access != RegisterAccess::WriteOnly, "register is write-only");
+    return (static_cast<std::uint64_t>(bus.read(base + field.offset)) & field.mask) >>
+           field.shift;
+}
+
+template <typename Map, RegisterBus Bus>
+template <FixedString Reg, FixedString Field>
+void RegisterBlock<Map, Bus>::writeField(std::uint64_t value) {
+    constexpr ResolvedRegister field = Map::template field<Reg, Field>;
+    static_assert(field.access == RegisterAccess::ReadWrite,
+                  "field writes read-modify-write the register");
+    const std::uint64_t old = bus.read(base + field.offset);
+    bus.write(base + field.offset,
+              (old & ~field.mask) | ((value << field.shift) & field.mask));
+}
+// End RegisterBlock Implementations
+
+} // namespace vsc
+
+#endif /* VSC_REGISTER_MAP_H_ */
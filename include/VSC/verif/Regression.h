@@ -0,0 +1,149 @@
+/** @file
+ * Regression runner scheduling bench tests over all cores.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_REGRESSION_H_
+#define VSC_REGRESSION_H_
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vsc {
+
+/**
+ * What a test function reports back to the runner.
+ */
+struct TestOutcome {
+    bool passed = false;
+    std::string message;
+};
+
+/**
+ * A test entry point. It receives the job's seed and is expected to build its own
+ * VerilatorBench (with its own VerilatedContext), since several jobs run concurrently.
+ */
+using TestFunction = std::function<TestOutcome(std::uint64_t seed)>;
+
+/**
+ * A test run with one seed
+ *
+ * The hashes make up the result cache key together with the test binary, see
+ * ResultCacheKey. With a cache configured every job needs a model hash, since the model
+ * may change without the test binary changing (e.g. hashFile() of the model library, or
+ * of the .so for a model plugin). Pass hashExecutable() when the model is linked
+ * statically into the test binary.
+ */
+struct RegressionJob {
+    std::string name;
+    std::uint64_t seed = 0;
+    TestFunction run;
+    std::optional<std::uint64_t> modelHash;
+    std::uint64_t stimulusHash = 0; // 0 for tests without input files
+};
+
+struct JobResult {
+    std::string name;
+    std::uint64_t seed = 0;
+    bool passed = false;
+    bool crashed = false; // forked job died from a signal or timed out
+    bool cached = false;  // pass taken from the result cache, the test did not run
+    std::string message;
+    double seconds = 0.0;
+};
+
+enum class Isolation {
+    InProcess, // run on a worker thread; fastest, but a crash takes down the regression
+    Forked,    // run in a child process per job; survives crashes and hangs
+};
+
+struct RegressionOptions {
+    unsigned workers = 0; // 0 = all cores
+    Isolation isolation = Isolation::InProcess;
+    std::string historyPath;     // runtime history file, empty = no history
+    double timeoutSeconds = 0.0; // per job, forked isolation only, 0 = none
+    std::string cacheDirectory;  // result cache location, empty = always run
+};
+
+/**
+ * Per-test runtime history used to order jobs longest-expected-first
+ *
+ * Runtimes are tracked per test name as an exponential moving average, since seeds
+ * usually change between runs. The file format is one "seconds<TAB>name" line per test.
+ */
+class RuntimeHistory {
+private:
+    std::unordered_map<std::string, double> averages;
+
+public:
+    /**
+     * Load a history file. A missing file yields an empty history.
+     */
+    static RuntimeHistory load(const std::string& path);
+    /**
+     * Write the history to a file. Throws std::runtime_error on I/O failure.
+     */
+    void save(const std::string& path) const;
+    std::optional<double> expected(const std::string& name) const;
+    void record(const std::string& name, double seconds);
+};
+
+/**
+ * Runs regression jobs longest-expected-first with work stealing across cores
+ *
+ * Jobs are sorted by their expected runtime from the history (unknown tests are assumed
+ * to be as long as the longest known one) and dealt to the workers in that order, so the
+ * long jobs start first and the short ones fill the tail. Idle workers steal queued jobs
+ * from busy ones.
+ *
+ * Forked jobs are started from the thread calling run(), which keeps up to the worker
+ * count of children running, longest expected first. No runner threads exist while it
+ * forks, so children cannot inherit locks held by other threads; the calling thread
+ * should likewise be the only thread of the process at that point.
+ *
+ * With a cache directory configured, jobs whose test binary, model, stimulus and seed
+ * all match a previous pass are answered from the cache without being scheduled. A pass
+ * that cannot be recorded in the cache is reported on stderr and otherwise ignored.
+ */
+class RegressionRunner {
+private:
+    RegressionOptions options;
+    std::vector<RegressionJob> jobs;
+
+    JobResult runJob(const RegressionJob& job) const;
+    void runForked(const std::vector<std::size_t>& order, std::vector<JobResult>& results,
+                   const std::function<void(std::size_t)>& finished) const;
+
+public:
+    explicit RegressionRunner(RegressionOptions options);
+    /**
+     * Add a job. Throws std::invalid_argument if a cache is configured and the job has
+     * no model hash.
+     */
+    void addJob(RegressionJob job);
+    /**
+     * Run every added job and update the runtime history.
+     * @return one result per job, in the order the jobs were added
+     */
+    std::vector<JobResult> run();
+};
+
+/**
+ * Write results as a JUnit XML report. Throws std::runtime_error on I/O failure.
+ */
+void writeJUnitReport(const std::vector<JobResult>& results, const std::string& suite,
+                      const std::string& path);
+/**
+ * Write results as a JSON array of job objects. Throws std::runtime_error on I/O
+ * failure.
+ */
+void writeJsonReport(const std::vector<JobResult>& results, const std::string& path);
+
+} // namespace vsc
+
+#endif /* VSC_REGRESSION_H_ */
@@ -0,0 +1,76 @@
+/** @file
+ * Content-addressed cache of passing regression results.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_RESULT_CACHE_H_
+#define VSC_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace vsc {
+
+/**
+ * Everything a test result depends on
+ *
+ * If none of these changed, re-running the test cannot produce a different outcome
+ * (assuming the test is deterministic for a given seed).
+ */
+struct ResultCacheKey {
+    std::string testName;
+    std::uint64_t seed = 0;
+    std::uint64_t binaryHash = 0;   // test executable, see hashExecutable()
+    std::uint64_t modelHash = 0;    // verilated model build, e.g. hashFile() of its .a
+    std::uint64_t stimulusHash = 0; // input files, e.g. hashFile() of a stimulus trace
+
+    /**
+     * Combine all fields into the 64-bit content address.
+     */
+    std::uint64_t digest() const;
+};
+
+/**
+ * Directory of passing results, one small file per key
+ *
+ * Only passes are cached: a failing test is always re-run so its failure is reproduced
+ * in the current run's logs. Entries are written to a temporary file and renamed into
+ * place, so several regressions can share a cache directory.
+ */
+class ResultCache {
+private:
+    std::string directory;
+
+    std::string entryPath(const ResultCacheKey& key) const;
+
+public:
+    /**
+     * Open (and create if needed) a cache directory.
+     */
+    explicit ResultCache(std::string directory);
+    /**
+     * Look up a cached pass.
+     * @return the recorded runtime in seconds, or nothing on a miss
+     */
+    std::optional<double> lookup(const ResultCacheKey& key) const;
+    /**
+     * Record a pass. Throws std::runtime_error or std::filesystem::filesystem_error if
+     * the entry cannot be written; no temporary file is left behind.
+     */
+    void store(const ResultCacheKey& key, double seconds) const;
+};
+
+/**
+ * Hash a file's contents. Throws std::runtime_error if the file cannot be read.
+ */
+std::uint64_t hashFile(const std::string& path);
+/**
+ * Hash the running executable.
+ */
+std::uint64_t hashExecutable();
+
+} // namespace vsc
+
+#endif /* VSC_RESULT_CACHE_H_ */
@@ -0,0 +1,142 @@
+/** @file
+ * Delta-debugging minimizer for failing stimulus traces.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_STIMULUS_MINIMIZER_H_
+#define VSC_STIMULUS_MINIMIZER_H_
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+#include "VSC/util/Parallel.h"
+#include "VSC/verif/StimulusTrace.h"
+
+namespace vsc {
+
+/**
+ * Failure oracle constraint
+ *
+ * A valid function must have the signature bool stillFails(const StimulusTrace& t). It
+ * is called concurrently from several worker threads, so it must build its own bench
+ * (e.g. via replayStimulus()) rather than share one.
+ */
+template <typename OracleFun>
+concept FailureOracle = std::predicate<OracleFun&, const StimulusTrace&>;
+
+struct MinimizerOptions {
+    unsigned workers = 0;    // candidate replays run concurrently, 0 = all cores
+    std::size_t maxRuns = 0; // stop after this many oracle calls, 0 = unbounded
+};
+
+struct MinimizerResult {
+    StimulusTrace trace;     // smallest failing trace found
+    std::size_t oracleRuns;  // number of candidate replays performed
+    bool oneMinimal;         // true if removing any single event makes the test pass
+};
+
+/**
+ * Shrink a failing stimulus trace with the ddmin algorithm.
+ *
+ * At each granularity the trace is split into n chunks, and every chunk and every chunk
+ * complement is replayed in parallel. The lowest-numbered failing candidate wins, so the
+ * result does not depend on thread timing, and candidates ordered after an already
+ * failing one are skipped. The input trace must fail the oracle.
+ * @param failing the original failing trace
+ * @param stillFails oracle that replays a candidate and reports whether it still fails
+ * @param options worker count and run budget
+ */
+template <FailureOracle OracleFun>
+MinimizerResult minimizeStimulus(const StimulusTrace& failing, OracleFun stillFails,
+                                 const MinimizerOptions& options = {});
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+template <FailureOracle OracleFun>
+MinimizerResult minimizeStimulus(const StimulusTrace& failing, OracleFun stillFails,
+                                 const MinimizerOptions& options) {
+    constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+    std::vector<std::size_t> current(failing.events.size());
+    std::iota(current.begin(), current.end(), 0);
+    std::size_t granularity = 2;
+    std::atomic<std::size_t> runs{0};
+    bool budgetExhausted = false;
+
+    while (current.size() >= 2) {
+        granularity = std::min(granularity, current.size());
+        // candidates [0, n) are the chunks, [n, 2n) their complements. With two chunks
+        // the complements are the chunks themselves, so only test them once.
+        std::vector<std::vector<std::size_t>> candidates;
+        const std::size_t chunkCount = granularity;
+        for (std::size_t i = 0; i < chunkCount; ++i) {
+            const std::size_t begin = current.size() * i / chunkCount;
+            const std::size_t end = current.size() * (i + 1) / chunkCount;
+            candidates.emplace_back(current.begin() + begin, current.begin() + end);
+        }
+        if (chunkCount > 2) {
+            for (std::size_t i = 0; i < chunkCount; ++i) {
+                std::vector<std::size_t> complement;
+                complement.reserve(current.size() - candidates[i].size());
+                for (std::size_t j = 0; j < chunkCount; ++j) {
+                    if (j != i) {
+                        complement.insert(complement.end(), candidates[j].begin(),
+                                          candidates[j].end());
+                    }
+                }
+                candidates.push_back(std::move(complement));
+            }
+        }
+
+        std::atomic<std::size_t> firstFailing{none};
+        parallelFor(candidates.size(), options.workers, [&](std::size_t index, unsigned) {
+            if (index > firstFailing.load(std::memory_order_relaxed)) {
+                return; // a lower-numbered candidate already reproduces
+            }
+            const std::size_t run = runs.fetch_add(1, std::memory_order_relaxed);
+            if (options.maxRuns != 0 && run >= options.maxRuns) {
+                return;
+            }
+            if (stillFails(failing.subset(candidates[index]))) {
+                std::size_t seen = firstFailing.load();
+                while (index < seen && !firstFailing.compare_exchange_weak(seen, index)) {
+                }
+            }
+        });
+        if (options.maxRuns != 0 && runs.load() >= options.maxRuns) {
+            budgetExhausted = true;
+        }
+
+        const std::size_t winner = firstFailing.load();
+        if (winner != none && winner < chunkCount) {
+            current = std::move(candidates[winner]);
+            granularity = 2;
+        } else if (winner != none) {
+            current = std::move(candidates[winner]);
+            granularity = std::max<std::size_t>(granularity - 1, 2);
+        } else if (granularity >= current.size()) {
+            break; // every single-event removal passes
+        } else {
+            granularity = std::min(granularity * 2, current.size());
+        }
+        if (budgetExhausted) {
+            break;
+        }
+    }
+
+    const std::size_t totalRuns =
+        options.maxRuns == 0 ? runs.load() : std::min(runs.load(), options.maxRuns);
+    return {failing.subset(current), totalRuns, !budgetExhausted};
+}
+
+} // namespace vsc
+
+#endif /* VSC_STIMULUS_MINIMIZER_H_ */
@@ -0,0 +1,118 @@
+/** @file
+ * Recorded stimulus traces and their on-disk replay format.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#ifndef VSC_STIMULUS_TRACE_H_
+#define VSC_STIMULUS_TRACE_H_
+
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "VSC/VerilatorBench.h"
+
+namespace vsc {
+
+/**
+ * One stimulus item: an opaque payload applied to the model at a given cycle.
+ *
+ * The payload layout is owned by the bench that recorded it. The library only moves the
+ * bytes around.
+ */
+struct StimulusEvent {
+    std::uint64_t cycle = 0; // cycle (counted from reset) to apply the payload at
+    std::vector<std::uint8_t> payload;
+};
+
+/**
+ * Stimulus applier callable constraint
+ *
+ * A valid function must have the signature
+ * void apply(TopModule* m, std::span<const std::uint8_t> payload)
+ */
+template <typename ApplyFun, typename TopModule>
+concept StimulusApplier =
+    std::invocable<ApplyFun&, TopModule*, std::span<const std::uint8_t>>;
+
+/**
+ * An ordered list of stimulus events that can be saved and replayed.
+ *
+ * Events must be sorted by cycle. Several events may target the same cycle, in which
+ * case they are applied in list order.
+ *
+ * File format (all integers little-endian):
+ *   - magic "VSCSTIM1" (8 bytes)
+ *   - u64 event count
+ *   - per event: u64 cycle, u32 payload size, payload bytes
+ */
+class StimulusTrace {
+public:
+    std::vector<StimulusEvent> events;
+
+    /**
+     * Append an event to the end of the trace.
+     */
+    void append(std::uint64_t cycle, std::span<const std::uint8_t> payload);
+    /**
+     * Build a new trace from the events at the given (ascending) indices.
+     */
+    StimulusTrace subset(std::span<const std::size_t> indices) const;
+    /**
+     * Get the cycle of the last event, or 0 for an empty trace.
+     */
+    std::uint64_t lastCycle() const;
+    /**
+     * Write the trace to a file in the replay format. Throws std::runtime_error on I/O
+     * failure.
+     */
+    void save(const std::string& path) const;
+    /**
+     * Read a trace from a file in the replay format. Throws std::runtime_error on I/O
+     * failure or if the file is not a valid trace.
+     */
+    static StimulusTrace load(const std::string& path);
+};
+
+/**
+ * Replay a stimulus trace on a freshly reset bench.
+ *
+ * Each event is applied once the bench reaches its cycle, before the cycle is advanced.
+ * After the last event the bench is advanced a further trailingCycles cycles to let the
+ * design react.
+ * @param bench bench to drive. Must already be reset.
+ * @param trace stimulus to apply
+ * @param apply callable that writes an event payload onto the model inputs
+ * @param trailingCycles cycles to run after the last event
+ */
+template <VerilatedToplevel TopModule, BenchPolicy... Policies,
+          StimulusApplier<TopModule> ApplyFun>
+void replayStimulus(VerilatorBench<TopModule, Policies...>& bench,
+                    const StimulusTrace& trace, ApplyFun apply,
+                    std::uint64_t trailingCycles = 0);
+
+///////////////////////////////////////////////////////////////////////////////
+// Template Method Implementations
+///////////////////////////////////////////////////////////////////////////////
+template <VerilatedToplevel TopModule, BenchPolicy... Policies,
+          StimulusApplier<TopModule> ApplyFun>
+void replayStimulus(VerilatorBench<TopModule, Policies...>& bench,
+                    const StimulusTrace& trace, ApplyFun apply,
+                    std::uint64_t trailingCycles) {
+    for (const StimulusEvent& event : trace.events) {
+        while (bench.getCycles() < event.cycle) {
+            bench.advanceCycle();
+        }
+        apply(bench.topmodule, std::span<const std::uint8_t>(event.payload));
+    }
+    for (std::uint64_t i = 0; i < trailingCycles; ++i) {
+        bench.advanceCycle();
+    }
+}
+
+} // namespace vsc
+
+#endif /* VSC_STIMULUS_TRACE_H_ */
@@ -0,0 +1,625 @@
+/** @file
+ * GDB remote serial protocol stub implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+#include "VSC/debug/GdbStub.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr std::size_t maxMemoryRead = 1024; // bytes per m reply, well below PacketSize
+constexpr int sigint = 2;
+constexpr int sigtrap = 5;
+constexpr char interruptByte = 0x03;
+
+constexpr const char* hexDigits = "0123456789abcdef";
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+void appendHexByte(std::string& out, std::uint8_t byte) {
+    out += hexDigits[byte >> 4];
+    out += hexDigits[byte & 0xf];
+}
+
+/**
+ * Parse a big endian hex number as used for addresses and lengths, advancing pos.
+ */
+std::uint64_t parseNumber(const std::string& text, std::size_t& pos) {
+    std::uint64_t value = 0;
+    for (; pos < text.size() && hexValue(text[pos]) >= 0; ++pos) {
+        value = (value << 4) | static_cast<std::uint64_t>(hexValue(text[pos]));
+    }
+    return value;
+}
+
+/**
+ * Decode hex byte pairs into bytes. Returns false on malformed input.
+ */
+bool decodeHex(const char* hex, std::size_t pairs, std::uint8_t* out) {
+    for (std::size_t i = 0; i < pairs; ++i) {
+        const int high = hexValue(hex[2 * i]);
+        const int low = hexValue(hex[2 * i + 1]);
+        if (high < 0 || low < 0) {
+            return false;
+        }
+        out[i] = static_cast<std::uint8_t>((high << 4) | low);
+    }
+    return true;
+}
+
+std::string registerHex(std::uint64_t value, std::size_t bytes) {
+    std::string out;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        appendHexByte(out, static_cast<std::uint8_t>(i < 8 ? value >> (8 * i) : 0));
+    }
+    return out;
+}
+
+/**
+ * Decode a little endian register value from hex; bytes beyond 8 are ignored. Returns
+ * false on malformed input.
+ */
+bool parseRegisterHex(const char* hex, std::size_t bytes, std::uint64_t& value) {
+    value = 0;
+    for (std::size_t i = 0; i < bytes; ++i) {
+        std::uint8_t byte = 0;
+        if (!decodeHex(hex + 2 * i, 1, &byte)) {
+            return false;
+        }
+        if (i < 8) {
+            value |= static_cast<std::uint64_t>(byte) << (8 * i);
+        }
+    }
+    return true;
+}
+
+/**
+ * write() with SIGPIPE blocked, so a debugger closing its end of a pipe fails the write
+ * with EPIPE instead of killing the simulation. A SIGPIPE raised by this write is
+ * consumed before the signal mask is restored.
+ */
+ssize_t writeWithoutSigpipe(int fd, const char* data, std::size_t size) {
+    sigset_t pipeSet;
+    sigset_t oldSet;
+    sigset_t pending;
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    sigpending(&pending);
+    const bool wasPending = sigismember(&pending, SIGPIPE) == 1;
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+    const ssize_t count = ::write(fd, data, size);
+    const int error = errno;
+    if (count < 0 && error == EPIPE && !wasPending) {
+        const timespec noWait{0, 0};
+        while (sigtimedwait(&pipeSet, nullptr, &noWait) < 0 && errno == EINTR) {
+        }
+    }
+    pthread_sigmask(SIG_SETMASK, &oldSet, nullptr);
+    errno = error;
+    return count;
+}
+
+std::string signalReply(int signal) {
+    std::string reply = "S";
+    appendHexByte(reply, static_cast<std::uint8_t>(signal));
+    return reply;
+}
+
+} // namespace
+
+// Begin GdbStub Implementations
+GdbStub::GdbStub(GdbTarget& target, const std::string& socketPath)
+    : target{target},
+      listenFd{-1},
+      inFd{-1},
+      outFd{-1},
+      isSocket{true},
+      socketPath{socketPath},
+      received{},
+      breakpoints{},
+      noAck{false},
+      stepping{false},
+      interruptRequested{false},
+      attachPending{false},
+      awaitingStop{false},
+      armed{false},
+      pendingReason{GdbStopReason::Interrupt},
+      lastSignal{sigtrap} {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        throw std::runtime_error("gdb socket path too long: " + socketPath);
+    }
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+    listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error("cannot create gdb socket: " +
+                                 std::string(std::strerror(errno)));
+    }
+    ::unlink(socketPath.c_str()); // left behind by a previous run
+    if (::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 ||
+        ::listen(listenFd, 1) != 0) {
+        const int error = errno;
+        ::close(listenFd);
+        throw std::runtime_error("cannot listen on " + socketPath + ": " +
+                                 std::strerror(error));
+    }
+}
+
+GdbStub::GdbStub(GdbTarget& target, int inFd, int outFd)
+    : target{target},
+      listenFd{-1},
+      inFd{inFd},
+      outFd{outFd},
+      isSocket{false},
+      socketPath{},
+      received{},
+      breakpoints{},
+      noAck{false},
+      stepping{false},
+      interruptRequested{false},
+      attachPending{true}, // the debugger is waiting for the target to stop
+      awaitingStop{false},
+      armed{true},
+      pendingReason{GdbStopReason::Interrupt},
+      lastSignal{sigtrap} {}
+
+GdbStub::~GdbStub() {
+    closeConnection();
+    if (listenFd >= 0) {
+        ::close(listenFd);
+        ::unlink(socketPath.c_str());
+    }
+}
+
+void GdbStub::updateArmed() {
+    armed = attachPending || interruptRequested || stepping || !breakpoints.empty();
+}
+
+void GdbStub::closeConnection() {
+    if (inFd >= 0 && isSocket) {
+        ::close(inFd);
+    }
+    inFd = -1;
+    outFd = -1;
+    received.clear();
+    breakpoints.clear(); // a detached target runs freely
+    noAck = false;
+    stepping = false;
+    interruptRequested = false;
+    attachPending = false;
+    awaitingStop = false;
+    updateArmed();
+}
+
+bool GdbStub::readAvailable(int timeoutMs) {
+    pollfd request{inFd, POLLIN, 0};
+    int ready;
+    do {
+        ready = ::poll(&request, 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+    if (ready <= 0) {
+        return ready == 0;
+    }
+    char buffer[4096];
+    ssize_t count;
+    do {
+        count = ::read(inFd, buffer, sizeof(buffer));
+    } while (count < 0 && errno == EINTR);
+    if (count <= 0) {
+        return false; // debugger went away
+    }
+    received.append(buffer, static_cast<std::size_t>(count));
+    return true;
+}
+
+bool GdbStub::nextPacket(std::string& packet) {
+    while (true) {
+        const std::size_t start = received.find('$');
+        if (start == std::string::npos) {
+            received.clear(); // only acks and interrupts, which mean nothing when halted
+            return false;
+        }
+        const std::size_t end = received.find('#', start);
+        if (end == std::string::npos || end + 2 >= received.size()) {
+            received.erase(0, start);
+            return false;
+        }
+        std::uint8_t checksum = 0;
+        for (std::size_t i = start + 1; i < end; ++i) {
+            checksum = static_cast<std::uint8_t>(checksum + received[i]);
+        }
+        std::uint8_t expected = 0;
+        const bool valid =
+            decodeHex(received.data() + end + 1, 1, &expected) && expected == checksum;
+        packet.assign(received, start + 1, end - start - 1);
+        received.erase(0, end + 3);
+        if (!noAck) {
+            sendRaw(valid ? "+" : "-");
+        }
+        if (valid) {
+            return true;
+        }
+    }
+}
+
+void GdbStub::sendRaw(const std::string& bytes) {
+    std::size_t sent = 0;
+    while (outFd >= 0 && sent < bytes.size()) {
+        const char* data = bytes.data() + sent;
+        const std::size_t size = bytes.size() - sent;
+        const ssize_t count = isSocket ? ::send(outFd, data, size, MSG_NOSIGNAL)
+                                       : writeWithoutSigpipe(outFd, data, size);
+        if (count < 0 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            closeConnection();
+            return;
+        }
+        sent += static_cast<std::size_t>(count);
+    }
+}
+
+void GdbStub::sendPacket(const std::string& data) {
+    std::uint8_t checksum = 0;
+    for (char c : data) {
+        checksum = static_cast<std::uint8_t>(checksum + c);
+    }
+    std::string frame = "$" + data + "#";
+    appendHexByte(frame, checksum);
+    sendRaw(frame);
+}
+
+bool GdbStub::poll() {
+    if (inFd < 0) {
+        if (listenFd < 0) {
+            return false;
+        }
+        pollfd request{listenFd, POLLIN, 0};
+        if (::poll(&request, 1, 0) <= 0) {
+            return false;
+        }
+        const int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            return false;
+        }
+        inFd = fd;
+        outFd = fd;
+        attachPending = true;
+        updateArmed();
+        return true;
+    }
+    if (!readAvailable(0)) {
+        closeConnection();
+        return false;
+    }
+    if (received.find(interruptByte) != std::string::npos) {
+        received.erase(std::remove(received.begin(), received.end(), interruptByte),
+                       received.end());
+        interruptRequested = true;
+        updateArmed();
+    }
+    return attachPending || interruptRequested;
+}
+
+bool GdbStub::slowShouldHalt(std::uint64_t pc) {
+    if (attachPending || interruptRequested) {
+        pendingReason = GdbStopReason::Interrupt;
+        return true;
+    }
+    if (stepping) {
+        pendingReason = GdbStopReason::Step;
+        return true;
+    }
+    if (std::find(breakpoints.begin(), breakpoints.end(), pc) != breakpoints.end()) {
+        pendingReason = GdbStopReason::Breakpoint;
+        return true;
+    }
+    return false;
+}
+
+GdbResume GdbStub::halt() {
+    return halt(pendingReason);
+}
+
+GdbResume GdbStub::halt(GdbStopReason reason) {
+    if (inFd < 0) {
+        return GdbResume::Continue;
+    }
+    // an interrupt on attach is not reported, the debugger asks with '?' instead
+    lastSignal = reason == GdbStopReason::Interrupt && !attachPending ? sigint : sigtrap;
+    attachPending = false;
+    interruptRequested = false;
+    stepping = false;
+    updateArmed();
+    if (awaitingStop) {
+        awaitingStop = false;
+        sendPacket(signalReply(lastSignal));
+    }
+
+    std::string packet;
+    while (inFd >= 0) {
+        if (!nextPacket(packet)) {
+            if (!readAvailable(-1)) {
+                closeConnection();
+            }
+            continue;
+        }
+        if (packet.empty()) {
+            sendPacket("");
+            continue;
+        }
+        std::string reply;
+        const std::string args = packet.substr(1);
+        switch (packet[0]) {
+            case '?':
+                reply = signalReply(lastSignal);
+                break;
+            case 'g':
+                reply = readRegisters();
+                break;
+            case 'G':
+                reply = writeRegisters(args);
+                break;
+            case 'p': {
+                std::size_t pos = 0;
+                const std::size_t reg = parseNumber(args, pos);
+                reply = reg < target.registerCount()
+                            ? registerHex(target.readRegister(reg),
+                                          target.registerBytes(reg))
+                            : "E01";
+                break;
+            }
+            case 'P': {
+                std::size_t pos = 0;
+                const std::size_t reg = parseNumber(args, pos);
+                if (reg >= target.registerCount() || pos >= args.size() ||
+                    args[pos] != '=' ||
+                    args.size() - pos - 1 < 2 * target.registerBytes(reg)) {
+                    reply = "E01";
+                    break;
+                }
+                std::uint64_t value;
+                if (!parseRegisterHex(args.c_str() + pos + 1, target.registerBytes(reg),
+                                      value)) {
+                    reply = "E01";
+                    break;
+                }
+                target.writeRegister(reg, value);
+                reply = "OK";
+                break;
+            }
+            case 'm':
+                reply = readMemory(args);
+                break;
+            case 'M':
+                reply = writeMemory(args, false);
+                break;
+            case 'X':
+                reply = writeMemory(args, true);
+                break;
+            case 'Z':
+            case 'z':
+                reply = updateBreakpoint(args, packet[0] == 'Z');
+                break;
+            case 'c':
+            case 's':
+                if (!args.empty()) {
+                    std::size_t pos = 0;
+                    target.writeRegister(target.pcRegister(), parseNumber(args, pos));
+                }
+                stepping = packet[0] == 's';
+                awaitingStop = true;
+                updateArmed();
+                return GdbResume::Continue;
+            case 'D':
+                sendPacket("OK");
+                closeConnection();
+                return GdbResume::Detach;
+            case 'k':
+                closeConnection();
+                return GdbResume::Kill;
+            case 'H':
+            case 'T':
+                reply = "OK"; // a single thread
+                break;
+            case 'q':
+            case 'Q':
+            case 'v':
+                reply = handleQuery(packet);
+                break;
+            default:
+                break; // unsupported, answered with an empty packet
+        }
+        sendPacket(reply);
+        if (packet == "QStartNoAckMode") {
+            noAck = true; // after acknowledging the request itself
+        }
+    }
+    return GdbResume::Detach;
+}
+
+std::string GdbStub::handleQuery(const std::string& packet) {
+    const std::string description = target.targetDescription();
+    if (packet.starts_with("qSupported")) {
+        return description.empty()
+                   ? "PacketSize=4000;QStartNoAckMode+"
+                   : "PacketSize=4000;QStartNoAckMode+;qXfer:features:read+";
+    }
+    if (packet == "QStartNoAckMode") {
+        return "OK";
+    }
+    if (packet == "qAttached") {
+        return "1";
+    }
+    if (packet == "qC") {
+        return "QC1";
+    }
+    if (packet == "qfThreadInfo") {
+        return "m1";
+    }
+    if (packet == "qsThreadInfo") {
+        return "l";
+    }
+    constexpr std::string_view features = "qXfer:features:read:target.xml:";
+    if (packet.starts_with(features) && !description.empty()) {
+        std::size_t pos = features.size();
+        const std::uint64_t offset = parseNumber(packet, pos);
+        ++pos; // ','
+        const std::uint64_t length = parseNumber(packet, pos);
+        if (offset >= description.size()) {
+            return "l";
+        }
+        const std::string chunk = description.substr(offset, length);
+        const bool last = offset + chunk.size() >= description.size();
+        std::string reply = last ? "l" : "m";
+        for (char c : chunk) {
+            if (c == '$' || c == '#' || c == '}' || c == '*') {
+                reply += '}';
+                reply += static_cast<char>(c ^ 0x20);
+            } else {
+                reply += c;
+            }
+        }
+        return reply;
+    }
+    return "";
+}
+
+std::string GdbStub::readRegisters() {
+    std::string reply;
+    for (std::size_t reg = 0; reg < target.registerCount(); ++reg) {
+        reply += registerHex(target.readRegister(reg), target.registerBytes(reg));
+    }
+    return reply;
+}
+
+std::string GdbStub::writeRegisters(const std::string& hex) {
+    // decode everything first, a malformed packet must not leave registers half written
+    std::vector<std::uint64_t> values;
+    std::size_t pos = 0;
+    for (std::size_t reg = 0; reg < target.registerCount(); ++reg) {
+        const std::size_t bytes = target.registerBytes(reg);
+        if (pos + 2 * bytes > hex.size()) {
+            break; // GDB may send fewer registers than the target has
+        }
+        std::uint64_t value;
+        if (!parseRegisterHex(hex.c_str() + pos, bytes, value)) {
+            return "E01";
+        }
+        values.push_back(value);
+        pos += 2 * bytes;
+    }
+    for (std::size_t reg = 0; reg < values.size(); ++reg) {
+        target.writeRegister(reg, values[reg]);
+    }
+    return "OK";
+}
+
+std::string GdbStub::readMemory(const std::string& args) {
+    std::size_t pos = 0;
+    const std::uint64_t address = parseNumber(args, pos);
+    ++pos; // ','
+    const std::size_t length =
+        std::min<std::size_t>(parseNumber(args, pos), maxMemoryRead);
+    std::uint8_t data[maxMemoryRead];
+    if (!target.readMemory(address, std::span(data, length))) {
+        return "E01";
+    }
+    std::string reply;
+    reply.reserve(2 * length);
+    for (std::size_t i = 0; i < length; ++i) {
+        appendHexByte(reply, data[i]);
+    }
+    return reply;
+}
+
+std::string GdbStub::writeMemory(const std::string& args, bool binary) {
+    std::size_t pos = 0;
+    const std::uint64_t address = parseNumber(args, pos);
+    ++pos; // ','
+    const std::size_t length = parseNumber(args, pos);
+    if (pos >= args.size() || args[pos] != ':') {
+        return "E01";
+    }
+    ++pos;
+    // check the length against the packet before allocating, a corrupt length field
+    // must be rejected rather than throw out of the stub
+    const std::size_t available = args.size() - pos;
+    if (length > (binary ? available : available / 2)) {
+        return "E01";
+    }
+    std::vector<std::uint8_t> data(length);
+    if (binary) {
+        std::size_t count = 0;
+        for (; pos < args.size() && count < length; ++pos) {
+            char c = args[pos];
+            if (c == '}' && pos + 1 < args.size()) {
+                c = static_cast<char>(args[++pos] ^ 0x20);
+            }
+            data[count++] = static_cast<std::uint8_t>(c);
+        }
+        if (count != length) {
+            return "E01";
+        }
+    } else if (!decodeHex(args.c_str() + pos, length, data.data())) {
+        return "E01";
+    }
+    if (length != 0 && !target.writeMemory(address, data)) {
+        return "E01";
+    }
+    return "OK";
+}
+
+std::string GdbStub::updateBreakpoint(const std::string& args, bool insert) {
+    // software and hardware breakpoints both compare the pc, watchpoints are unsupported
+    if (args.size() < 3 || (args[0] != '0' && args[0] != '1') || args[1] != ',') {
+        return "";
+    }
+    std::size_t pos = 2;
+    const std::uint64_t address = parseNumber(args, pos);
+    const auto existing = std::find(breakpoints.begin(), breakpoints.end(), address);
+    if (insert && existing == breakpoints.end()) {
+        breakpoints.push_back(address);
+    } else if (!insert && existing != breakpoints.end()) {
+        breakpoints.erase(existing);
+    }
+    updateArmed();
+    return "OK";
+}
+// End GdbStub Implementations
+
+} // namespace vsc
@@ -0,0 +1,63 @@
+/** @file
+ * Lazy windowing system initialization.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <GLFW/glfw3.h>
+
+#include "VSC/gfx/GfxContext.h"
+
+namespace vsc {
+
+namespace {
+
+std::once_flag initFlag;
+std::atomic<bool> initialized{false};
+std::string initError;
+std::thread::id initThread; // written once under initFlag
+
+void initialize() {
+    initThread = std::this_thread::get_id();
+    if (glfwInit() != GLFW_TRUE) {
+        const char* description = nullptr;
+        glfwGetError(&description);
+        initError = description ? description : "unknown error";
+        return;
+    }
+    std::atexit([] { glfwTerminate(); });
+    initialized.store(true, std::memory_order_release);
+}
+
+} // namespace
+
+void ensureGfxInitialized() {
+    std::call_once(initFlag, initialize);
+    // GLFW must be initialized, used and terminated on one thread, call_once alone
+    // would let a sim or I/O thread take that role without noticing
+    if (std::this_thread::get_id() != initThread) {
+        throw std::logic_error("GLFW is used from a thread other than the one that "
+                               "initialized it");
+    }
+    if (!initialized.load(std::memory_order_acquire)) {
+        throw std::runtime_error("failed to initialize GLFW: " + initError);
+    }
+}
+
+bool isGfxInitialized() {
+    return initialized.load(std::memory_order_acquire);
+}
+
+bool isVulkanSupported() {
+    ensureGfxInitialized();
+    return glfwVulkanSupported() == GLFW_TRUE;
+}
+
+} // namespace vsc
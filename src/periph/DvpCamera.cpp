@@ -0,0 +1,402 @@
+/** @file
+ * DVP camera source implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <algorithm>
+#include <array>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#include "VSC/periph/DvpCamera.h"
+#include "VSC/util/Trace.h"
+
+namespace vsc {
+
+namespace {
+
+struct Yuv {
+    std::uint8_t y;
+    std::uint8_t u;
+    std::uint8_t v;
+};
+
+std::uint8_t clampByte(int value) {
+    return static_cast<std::uint8_t>(std::clamp(value, 0, 255));
+}
+
+// ITU-R BT.601, limited range
+constexpr Yuv rgbToYuv(int r, int g, int b) {
+    return {static_cast<std::uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16),
+            static_cast<std::uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128),
+            static_cast<std::uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128)};
+}
+
+std::size_t subsampled(unsigned size, unsigned shift) {
+    return (size + (1u << shift) - 1) >> shift;
+}
+
+std::uint16_t yuvToRgb565(int y, int u, int v) {
+    const int c = 298 * (y - 16) + 128;
+    const int d = u - 128;
+    const int e = v - 128;
+    const std::uint8_t r = clampByte((c + 409 * e) >> 8);
+    const std::uint8_t g = clampByte((c - 100 * d - 208 * e) >> 8);
+    const std::uint8_t b = clampByte((c + 516 * d) >> 8);
+    return static_cast<std::uint16_t>((r >> 3) << 11 | (g >> 2) << 5 | (b >> 3));
+}
+
+constexpr std::array<Yuv, 8> colourBars = {
+    rgbToYuv(255, 255, 255), rgbToYuv(255, 255, 0), rgbToYuv(0, 255, 255),
+    rgbToYuv(0, 255, 0),     rgbToYuv(255, 0, 255), rgbToYuv(255, 0, 0),
+    rgbToYuv(0, 0, 255),     rgbToYuv(0, 0, 0)};
+constexpr Yuv white = colourBars[0];
+constexpr Yuv black = colourBars[7];
+constexpr Yuv grey = rgbToYuv(128, 128, 128);
+
+} // namespace
+
+// Begin DvpCamera Implementations
+DvpCamera::DvpCamera(const std::string& path, const DvpOptions& options)
+    : options{options},
+      source{Source::Pattern},
+      width{options.width},
+      height{options.height},
+      lineBytes{0},
+      frameBytes{0},
+      stats{},
+      firstFrame{0},
+      chromaShiftX{0},
+      chromaShiftY{0},
+      chroma{true},
+      produced{0},
+      readIndex{0},
+      writeIndex{0},
+      ready{0},
+      holding{false},
+      sourceEnded{false},
+      phase{Phase::Start},
+      current{nullptr},
+      pos{0},
+      line{0},
+      countdown{0} {
+    if (path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0) {
+        source = Source::Y4m;
+        openY4m(path);
+    } else if (!path.empty()) {
+        source = Source::Raw;
+        file.open(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("cannot open camera frames: " + path);
+        }
+    }
+    if (width == 0 || height == 0) {
+        throw std::runtime_error("camera frames must not be empty");
+    }
+    if (options.format == DvpPixelFormat::Yuv422 && width % 2 != 0) {
+        throw std::runtime_error("YUV 4:2:2 output needs an even frame width");
+    }
+    lineBytes = static_cast<std::size_t>(width) *
+                (options.format == DvpPixelFormat::Gray8 ? 1 : 2);
+    frameBytes = lineBytes * height;
+    if (source == Source::Raw) {
+        file.seekg(0, std::ios::end);
+        const auto size = static_cast<std::size_t>(file.tellg());
+        if (size == 0 || size % frameBytes != 0) {
+            throw std::runtime_error("raw camera file " + path +
+                                     " is not a whole number of frames");
+        }
+        file.seekg(0);
+    }
+
+    yuvLine.resize(3 * static_cast<std::size_t>(width));
+    buffers.resize(std::max(options.bufferFrames, 2u));
+    for (std::vector<std::uint8_t>& buffer : buffers) {
+        buffer.resize(frameBytes);
+    }
+    pins.vsync = !options.vsyncActiveHigh;
+    prefetcher = std::jthread([this](std::stop_token stop) { prefetch(stop); });
+}
+
+DvpCamera::~DvpCamera() {
+    prefetcher.request_stop();
+    if (prefetcher.joinable()) {
+        prefetcher.join();
+    }
+}
+
+void DvpCamera::openY4m(const std::string& path) {
+    file.open(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("cannot open camera video: " + path);
+    }
+    std::string header;
+    if (!std::getline(file, header) || header.rfind("YUV4MPEG2", 0) != 0) {
+        throw std::runtime_error("not a YUV4MPEG2 file: " + path);
+    }
+    std::istringstream tokens(header.substr(9));
+    std::string colourSpace = "420jpeg";
+    for (std::string token; tokens >> token;) {
+        if (token[0] == 'W') {
+            width = static_cast<unsigned>(std::stoul(token.substr(1)));
+        } else if (token[0] == 'H') {
+            height = static_cast<unsigned>(std::stoul(token.substr(1)));
+        } else if (token[0] == 'C') {
+            colourSpace = token.substr(1);
+        }
+    }
+
+    if (colourSpace == "420jpeg" || colourSpace == "420paldv" ||
+        colourSpace == "420mpeg2" || colourSpace == "420") {
+        chromaShiftX = 1;
+        chromaShiftY = 1;
+    } else if (colourSpace == "422") {
+        chromaShiftX = 1;
+    } else if (colourSpace == "mono") {
+        chroma = false;
+    } else if (colourSpace != "444") {
+        throw std::runtime_error("unsupported Y4M colour space " + colourSpace + ": " +
+                                 path);
+    }
+    const std::size_t lumaBytes = static_cast<std::size_t>(width) * height;
+    const std::size_t chromaBytes =
+        chroma ? subsampled(width, chromaShiftX) * subsampled(height, chromaShiftY) : 0;
+    planes.resize(lumaBytes + 2 * chromaBytes);
+    firstFrame = file.tellg();
+}
+
+void DvpCamera::packLine(std::uint8_t* out) const {
+    const std::uint8_t* yuv = yuvLine.data();
+    switch (options.format) {
+        case DvpPixelFormat::Gray8:
+            for (unsigned x = 0; x < width; ++x) {
+                out[x] = yuv[3 * x];
+            }
+            break;
+        case DvpPixelFormat::Rgb565:
+            for (unsigned x = 0; x < width; ++x) {
+                const std::uint8_t* pixel = yuv + 3 * x;
+                const std::uint16_t rgb = yuvToRgb565(pixel[0], pixel[1], pixel[2]);
+                out[2 * x] = static_cast<std::uint8_t>(rgb >> 8);
+                out[2 * x + 1] = static_cast<std::uint8_t>(rgb);
+            }
+            break;
+        case DvpPixelFormat::Yuv422:
+            for (unsigned x = 0; x < width; x += 2) {
+                const std::uint8_t* pair = yuv + 3 * x;
+                out[2 * x] = pair[0];
+                out[2 * x + 1] = static_cast<std::uint8_t>((pair[1] + pair[4] + 1) / 2);
+                out[2 * x + 2] = pair[3];
+                out[2 * x + 3] = static_cast<std::uint8_t>((pair[2] + pair[5] + 1) / 2);
+            }
+            break;
+    }
+}
+
+bool DvpCamera::readY4mFrame(std::uint8_t* out) {
+    std::string header;
+    if (!std::getline(file, header)) {
+        return false;
+    }
+    if (header.rfind("FRAME", 0) != 0) {
+        throw std::runtime_error("malformed Y4M frame header");
+    }
+    file.read(reinterpret_cast<char*>(planes.data()),
+              static_cast<std::streamsize>(planes.size()));
+    if (static_cast<std::size_t>(file.gcount()) != planes.size()) {
+        throw std::runtime_error("truncated Y4M frame");
+    }
+
+    const std::uint8_t* lumaPlane = planes.data();
+    const std::size_t chromaWidth = subsampled(width, chromaShiftX);
+    const std::size_t chromaHeight = subsampled(height, chromaShiftY);
+    const std::uint8_t* uPlane = lumaPlane + static_cast<std::size_t>(width) * height;
+    const std::uint8_t* vPlane = uPlane + chromaWidth * chromaHeight;
+    for (unsigned y = 0; y < height; ++y) {
+        const std::uint8_t* luma = lumaPlane + static_cast<std::size_t>(y) * width;
+        const std::size_t chromaRow = (y >> chromaShiftY) * chromaWidth;
+        for (unsigned x = 0; x < width; ++x) {
+            yuvLine[3 * x] = luma[x];
+            yuvLine[3 * x + 1] = chroma ? uPlane[chromaRow + (x >> chromaShiftX)] : 128;
+            yuvLine[3 * x + 2] = chroma ? vPlane[chromaRow + (x >> chromaShiftX)] : 128;
+        }
+        packLine(out + y * lineBytes);
+    }
+    return true;
+}
+
+void DvpCamera::renderPattern(std::uint8_t* out) {
+    const unsigned block = std::max(8u, std::min(width, height) / 8);
+    const unsigned blockX =
+        width > block ? static_cast<unsigned>(produced * 4 % (width - block)) : 0;
+    const unsigned blockY =
+        height > block ? static_cast<unsigned>(produced * 2 % (height - block)) : 0;
+    for (unsigned y = 0; y < height; ++y) {
+        const bool blockRow = y >= blockY && y < blockY + block;
+        for (unsigned x = 0; x < width; ++x) {
+            const std::size_t bar = std::size_t{x} * colourBars.size() / width;
+            Yuv pixel = colourBars[bar];
+            if (blockRow && x >= blockX && x < blockX + block) {
+                pixel = grey;
+            }
+            if (y == 0 && x < 32) {
+                pixel = (produced >> x) & 1 ? white : black;
+            }
+            yuvLine[3 * x] = pixel.y;
+            yuvLine[3 * x + 1] = pixel.u;
+            yuvLine[3 * x + 2] = pixel.v;
+        }
+        packLine(out + y * lineBytes);
+    }
+}
+
+bool DvpCamera::produceFrame(std::uint8_t* out) {
+    TraceSpan span("camera frame", "periph");
+    switch (source) {
+        case Source::Pattern:
+            if (options.patternFrames != 0 && produced >= options.patternFrames) {
+                return false;
+            }
+            renderPattern(out);
+            break;
+        case Source::Raw:
+        case Source::Y4m: {
+            const auto readFrame = [&] {
+                if (source == Source::Y4m) {
+                    return readY4mFrame(out);
+                }
+                file.read(reinterpret_cast<char*>(out),
+                          static_cast<std::streamsize>(frameBytes));
+                return static_cast<std::size_t>(file.gcount()) == frameBytes;
+            };
+            if (!readFrame()) {
+                if (!options.loop || produced == 0) {
+                    return false;
+                }
+                file.clear();
+                file.seekg(firstFrame);
+                if (!readFrame()) {
+                    return false;
+                }
+            }
+            break;
+        }
+    }
+    ++produced;
+    return true;
+}
+
+void DvpCamera::prefetch(std::stop_token stop) {
+    setTraceThreadName("camera prefetch");
+    try {
+        while (true) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                const bool hasRoom = changed.wait(guard, stop, [&] {
+                    return ready + (holding ? 1 : 0) < buffers.size();
+                });
+                if (!hasRoom) {
+                    return; // stop requested
+                }
+            }
+            // the buffer at writeIndex is neither ready nor held, so no lock is needed
+            if (!produceFrame(buffers[writeIndex].data())) {
+                break;
+            }
+            std::lock_guard<std::mutex> guard(lock);
+            writeIndex = (writeIndex + 1) % buffers.size();
+            ++ready;
+            changed.notify_all();
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> guard(lock);
+        error = std::current_exception();
+    }
+    std::lock_guard<std::mutex> guard(lock);
+    sourceEnded = true;
+    changed.notify_all();
+}
+
+bool DvpCamera::acquireFrame() {
+    std::unique_lock<std::mutex> guard(lock);
+    if (ready == 0 && !sourceEnded) {
+        // the first frame is always waited for while the prefetcher starts up, only
+        // later waits mean the source cannot keep up with the simulation
+        if (stats.framesSent > 0) {
+            ++stats.stalls;
+        }
+        TraceSpan span("camera wait", "periph");
+        changed.wait(guard, [&] { return ready > 0 || sourceEnded; });
+    }
+    if (ready == 0) {
+        if (error) {
+            std::rethrow_exception(std::exchange(error, nullptr));
+        }
+        return false;
+    }
+    current = buffers[readIndex].data();
+    readIndex = (readIndex + 1) % buffers.size();
+    --ready;
+    holding = true;
+    return true;
+}
+
+void DvpCamera::releaseFrame() {
+    std::lock_guard<std::mutex> guard(lock);
+    holding = false;
+    changed.notify_all();
+}
+
+void DvpCamera::advance() {
+    while (countdown == 0) {
+        switch (phase) {
+            case Phase::FrontPorch:
+                releaseFrame();
+                [[fallthrough]];
+            case Phase::Start:
+                phase = Phase::Done; // until a frame is available
+                pins = {!options.vsyncActiveHigh, false, 0};
+                if (!acquireFrame()) {
+                    return;
+                }
+                phase = Phase::Vsync;
+                countdown = options.vsyncClocks;
+                break;
+            case Phase::Vsync:
+                phase = Phase::BackPorch;
+                countdown = options.backPorchClocks;
+                break;
+            case Phase::BackPorch:
+                phase = Phase::Line;
+                line = 0;
+                pos = 0;
+                countdown = static_cast<unsigned>(lineBytes);
+                break;
+            case Phase::Line:
+                if (++line < height) {
+                    phase = Phase::Hblank;
+                    countdown = options.hblankClocks;
+                } else {
+                    phase = Phase::FrontPorch;
+                    countdown = options.frontPorchClocks;
+                    ++stats.framesSent;
+                }
+                break;
+            case Phase::Hblank:
+                phase = Phase::Line;
+                countdown = static_cast<unsigned>(lineBytes);
+                break;
+            case Phase::Done:
+                return;
+        }
+    }
+    --countdown;
+    pins.vsync = (phase == Phase::Vsync) == options.vsyncActiveHigh;
+    pins.href = phase == Phase::Line;
+    pins.data = phase == Phase::Line ? current[pos++] : 0;
+}
+// End DvpCamera Implementations
+
+} // namespace vsc
@@ -0,0 +1,241 @@
+/** @file
+ * Ethernet MII/RGMII transactor implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "VSC/periph/EthernetTransactor.h"
+#include "VSC/util/Crc.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr std::uint8_t preambleByte = 0x55;
+constexpr std::uint8_t sfdByte = 0xd5;
+constexpr std::size_t fcsBytes = 4;
+
+/**
+ * Frame check sequence over a whole frame (IEEE 802.3 CRC-32).
+ */
+std::uint32_t frameCrc(const std::uint8_t* data, std::size_t size) {
+    return crcFor<crc32Ieee>().compute({data, size});
+}
+
+} // namespace
+
+// Begin EthernetTransactor Implementations
+EthernetTransactor::EthernetTransactor(const std::string& inputPath,
+                                       const std::string& outputPath,
+                                       const EthernetOptions& options)
+    : options{options},
+      stats{},
+      symbolsPerByte{options.interface == EthernetInterface::Mii ? 2u : 1u},
+      nextPacket{0},
+      rxSymbols{0},
+      gapSymbols{0},
+      rxLength{0},
+      rxPos{0},
+      rxHighNibble{false},
+      txSymbols{0},
+      txStart{0},
+      txLength{0},
+      txNibble{0},
+      txActive{false},
+      txPreamble{false},
+      txHighNibble{false},
+      txError{false},
+      txOverflow{false},
+      txMisaligned{false} {
+    if (!inputPath.empty()) {
+        input.emplace(inputPath);
+        if (input->getLinkType() != pcapLinkEthernet) {
+            throw std::runtime_error("capture does not contain Ethernet frames: " +
+                                     inputPath);
+        }
+    }
+    if (!outputPath.empty()) {
+        output.emplace(outputPath, pcapLinkEthernet);
+    }
+}
+
+void EthernetTransactor::flush() {
+    if (output) {
+        output->flush();
+    }
+}
+
+std::uint64_t EthernetTransactor::timestampNs(std::uint64_t symbols) const {
+    return static_cast<std::uint64_t>(static_cast<long double>(symbols) * 8e9L /
+                                      (static_cast<long double>(options.bitsPerSecond) *
+                                       symbolsPerByte));
+}
+
+bool EthernetTransactor::loadNextFrame() {
+    if (!input || nextPacket >= input->size()) {
+        return false;
+    }
+    const PcapPacket& packet = (*input)[nextPacket];
+    if (options.paceByTimestamps) {
+        const std::uint64_t first = (*input)[0].timestampNs;
+        const long double offsetNs =
+            packet.timestampNs > first ? packet.timestampNs - first : 0;
+        const long double startSymbol = offsetNs * 1e-9L *
+                                        static_cast<long double>(options.bitsPerSecond) /
+                                        8 * symbolsPerByte;
+        if (static_cast<long double>(rxSymbols) < startSymbol) {
+            return false;
+        }
+    }
+    ++nextPacket;
+
+    std::size_t length = packet.data.size();
+    const std::size_t padded = std::max(length, minFrameBytes - fcsBytes);
+    if ((options.appendFcs ? padded + fcsBytes : length) > maxFrameBytes) {
+        ++stats.lengthErrors;
+        return false;
+    }
+    std::uint8_t* frame = rxWire.data() + preambleBytes;
+    std::fill_n(rxWire.begin(), preambleBytes - 1, preambleByte);
+    rxWire[preambleBytes - 1] = sfdByte;
+    std::memcpy(frame, packet.data.data(), length);
+    if (options.appendFcs) {
+        std::memset(frame + length, 0, padded - length);
+        length = padded;
+        const std::uint32_t fcs = frameCrc(frame, length);
+        for (std::size_t i = 0; i < fcsBytes; ++i) {
+            frame[length++] = static_cast<std::uint8_t>(fcs >> (8 * i));
+        }
+    }
+    rxLength = preambleBytes + length;
+    rxPos = 0;
+    rxHighNibble = false;
+    ++stats.framesSent;
+    return true;
+}
+
+EthernetLane EthernetTransactor::nextRx() {
+    EthernetLane lane;
+    ++rxSymbols;
+    if (rxPos >= rxLength) {
+        if (gapSymbols > 0) {
+            --gapSymbols;
+            return lane;
+        }
+        if (!loadNextFrame()) {
+            return lane;
+        }
+    }
+
+    lane.valid = true;
+    const std::uint8_t byte = rxWire[rxPos];
+    if (options.interface == EthernetInterface::Rgmii) {
+        lane.data = byte;
+        ++rxPos;
+    } else {
+        lane.data = rxHighNibble ? byte >> 4 : byte & 0xf;
+        rxPos += rxHighNibble ? 1 : 0;
+        rxHighNibble = !rxHighNibble;
+    }
+    if (rxPos == rxLength) {
+        gapSymbols = static_cast<std::uint64_t>(options.interFrameGap) * symbolsPerByte;
+    }
+    return lane;
+}
+
+void EthernetTransactor::tx(const EthernetLane& lane) {
+    ++txSymbols;
+    if (!lane.valid) {
+        if (txActive) {
+            txActive = false;
+            finishFrame();
+        }
+        return;
+    }
+    if (!txActive) {
+        txActive = true;
+        txStart = txSymbols - 1;
+        txLength = 0;
+        txPreamble = true;
+        txHighNibble = false;
+        txError = false;
+        txOverflow = false;
+        txMisaligned = false;
+    }
+    txError = txError || lane.error;
+
+    if (options.interface == EthernetInterface::Rgmii) {
+        receiveByte(lane.data);
+        return;
+    }
+    const std::uint8_t nibble = lane.data & 0xf;
+    if (txPreamble) {
+        // searching nibble by nibble also finds an SFD on an odd nibble
+        if (nibble == (sfdByte >> 4)) {
+            txPreamble = false;
+        } else if (nibble != (preambleByte & 0xf)) {
+            txMisaligned = true;
+        }
+    } else if (!txHighNibble) {
+        txNibble = nibble;
+        txHighNibble = true;
+    } else {
+        txHighNibble = false;
+        receiveByte(static_cast<std::uint8_t>(txNibble | nibble << 4));
+    }
+}
+
+void EthernetTransactor::receiveByte(std::uint8_t byte) {
+    if (txPreamble) {
+        if (byte == sfdByte) {
+            txPreamble = false;
+        } else if (byte != preambleByte) {
+            txMisaligned = true;
+        }
+    } else if (txLength < txFrame.size()) {
+        txFrame[txLength++] = byte;
+    } else {
+        txOverflow = true;
+    }
+}
+
+void EthernetTransactor::finishFrame() {
+    if (txPreamble) { // no SFD, nothing to record
+        ++stats.alignmentErrors;
+        return;
+    }
+    ++stats.framesReceived;
+    if (txMisaligned || txHighNibble) {
+        ++stats.alignmentErrors;
+    }
+    if (txError) {
+        ++stats.codeErrors;
+    }
+    if (txOverflow || txLength < minFrameBytes) {
+        ++stats.lengthErrors;
+    }
+    if (txLength < fcsBytes) {
+        ++stats.fcsErrors;
+    } else {
+        std::uint32_t fcs = 0;
+        for (std::size_t i = 0; i < fcsBytes; ++i) {
+            const std::uint32_t byte = txFrame[txLength - fcsBytes + i];
+            fcs |= byte << (8 * i);
+        }
+        if (txOverflow || frameCrc(txFrame.data(), txLength - fcsBytes) != fcs) {
+            ++stats.fcsErrors;
+        }
+    }
+    if (output) {
+        const std::size_t length =
+            options.stripFcs && txLength >= fcsBytes ? txLength - fcsBytes : txLength;
+        output->write(timestampNs(txStart), {txFrame.data(), length});
+    }
+}
+// End EthernetTransactor Implementations
+
+} // namespace vsc
@@ -0,0 +1,137 @@
+/** @file
+ * 8b/10b code tables, generated while compiling.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <bit>
+
+#include "VSC/periph/LineCode.h"
+
+namespace vsc {
+
+namespace {
+
+/**
+ * Sub-block written as in the standard, first transmitted bit leftmost.
+ */
+constexpr unsigned bits(const char* code) {
+    unsigned value = 0;
+    for (unsigned i = 0; code[i] != '\0'; ++i) {
+        value |= (code[i] == '1' ? 1u : 0u) << i;
+    }
+    return value;
+}
+
+constexpr int disparityOf(unsigned code, int width) {
+    return 2 * std::popcount(code) - width;
+}
+
+// abcdei for RD-
+constexpr const char* data5b6b[32] = {
+    "100111", "011101", "101101", "110001", "110101", "101001", "011001", "111000",
+    "111001", "100101", "010101", "110100", "001101", "101100", "011100", "010111",
+    "011011", "100011", "010011", "110010", "001011", "101010", "011010", "111010",
+    "110011", "100110", "010110", "110110", "001110", "101110", "011110", "101011"};
+constexpr const char* control5b6b = "001111"; // K.28
+
+// fghj for a negative disparity after the 6b sub-block, D.x.P7 at index 7
+constexpr const char* data3b4b[8] = {"1011", "1001", "0101", "1100",
+                                     "1101", "1010", "0110", "1110"};
+constexpr const char* dataA7 = "0111";
+constexpr const char* control3b4b[8] = {"1011", "0110", "1010", "1100",
+                                        "1101", "0101", "1001", "0111"};
+
+struct Encoded {
+    unsigned code;
+    unsigned disparity;
+    bool valid;
+};
+
+constexpr Encoded encodeSymbol(unsigned byte, bool control, unsigned disparity) {
+    const unsigned x = byte & 0x1f;
+    const unsigned y = byte >> 5;
+    const bool valid = !control || x == 28 ||
+                       (y == 7 && (x == 23 || x == 27 || x == 29 || x == 30));
+
+    unsigned six = bits(control && x == 28 ? control5b6b : data5b6b[x]);
+    if (disparity && (disparityOf(six, 6) != 0 || six == bits("111000"))) {
+        six ^= 0x3f;
+    }
+    if (disparityOf(six, 6) != 0) {
+        disparity = disparityOf(six, 6) > 0;
+    }
+
+    unsigned four;
+    if (control) {
+        four = bits(control3b4b[y]);
+        if (disparity) {
+            four ^= 0xf;
+        }
+    } else {
+        // A7 avoids runs of five equal bits across the sub-block boundary
+        const bool alternate = y == 7 && (disparity ? (x == 11 || x == 13 || x == 14)
+                                                    : (x == 17 || x == 18 || x == 20));
+        four = bits(alternate ? dataA7 : data3b4b[y]);
+        if (disparity && (disparityOf(four, 4) != 0 || four == bits("1100"))) {
+            four ^= 0xf;
+        }
+    }
+    if (disparityOf(four, 4) != 0) {
+        disparity = disparityOf(four, 4) > 0;
+    }
+    return {six | four << 6, disparity, valid};
+}
+
+} // namespace
+
+namespace internal {
+
+constinit const std::array<std::uint16_t, 1024> encode8b10bTable = [] {
+    std::array<std::uint16_t, 1024> table{};
+    for (unsigned index = 0; index < table.size(); ++index) {
+        const Encoded encoded = encodeSymbol(index & 0xff, (index >> 8) & 1, index >> 9);
+        table[index] = static_cast<std::uint16_t>(encoded.code | encoded.disparity << 10 |
+                                                  (encoded.valid ? 0u : 1u) << 11);
+    }
+    return table;
+}();
+
+constinit const std::array<std::uint16_t, 2048> decode8b10bTable = [] {
+    constexpr std::uint16_t unset = 0xffff;
+    std::array<std::uint16_t, 2048> table{};
+    table.fill(unset);
+    for (unsigned disparity = 0; disparity < 2; ++disparity) {
+        for (unsigned control = 0; control < 2; ++control) {
+            for (unsigned byte = 0; byte < 256; ++byte) {
+                const Encoded encoded = encodeSymbol(byte, control, disparity);
+                if (encoded.valid) {
+                    table[disparity << 10 | encoded.code] = static_cast<std::uint16_t>(
+                        byte | control << 8 | encoded.disparity << 9);
+                }
+            }
+        }
+    }
+    for (unsigned disparity = 0; disparity < 2; ++disparity) {
+        for (unsigned code = 0; code < 1024; ++code) {
+            std::uint16_t& entry = table[disparity << 10 | code];
+            if (entry != unset) {
+                continue;
+            }
+            const std::uint16_t other = table[(disparity ^ 1) << 10 | code];
+            if (other != unset && (other & 0xc00) == 0) {
+                entry = other | 0x800; // valid code for the opposite disparity
+                continue;
+            }
+            // keep following the line so the next symbols decode properly
+            const int balance = disparityOf(code, 10);
+            const unsigned next = balance == 0 ? disparity : balance > 0 ? 1 : 0;
+            entry = static_cast<std::uint16_t>(next << 9 | 0x400);
+        }
+    }
+    return table;
+}();
+
+} // namespace internal
+
+} // namespace vsc
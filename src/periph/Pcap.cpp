@@ -0,0 +1,126 @@
+/** @file
+ * Packet capture file I/O.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+#include "VSC/periph/Pcap.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr std::uint32_t magicMicroseconds = 0xa1b2c3d4;
+constexpr std::uint32_t magicNanoseconds = 0xa1b23c4d;
+constexpr std::size_t fileHeaderBytes = 24;
+constexpr std::size_t recordHeaderBytes = 16;
+
+std::uint32_t swapBytes(std::uint32_t value) {
+    return (value >> 24) | ((value >> 8) & 0xff00) | ((value << 8) & 0xff0000) |
+           (value << 24);
+}
+
+std::uint32_t loadLe32(const std::uint8_t* bytes) {
+    return static_cast<std::uint32_t>(bytes[0]) |
+           static_cast<std::uint32_t>(bytes[1]) << 8 |
+           static_cast<std::uint32_t>(bytes[2]) << 16 |
+           static_cast<std::uint32_t>(bytes[3]) << 24;
+}
+
+void storeLe32(std::uint8_t* bytes, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        bytes[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+}
+
+} // namespace
+
+// Begin PcapReader Implementations
+PcapReader::PcapReader(const std::string& path) : linkType{0} {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("cannot open capture file: " + path);
+    }
+    contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (contents.size() < fileHeaderBytes) {
+        throw std::runtime_error("not a pcap file: " + path);
+    }
+
+    const std::uint32_t magic = loadLe32(contents.data());
+    const bool swapped =
+        magic == swapBytes(magicMicroseconds) || magic == swapBytes(magicNanoseconds);
+    const std::uint32_t nativeMagic = swapped ? swapBytes(magic) : magic;
+    if (nativeMagic != magicMicroseconds && nativeMagic != magicNanoseconds) {
+        throw std::runtime_error("not a pcap file (pcapng is not supported): " + path);
+    }
+    const std::uint64_t fractionNs = nativeMagic == magicNanoseconds ? 1 : 1000;
+    const auto field = [&](std::size_t offset) {
+        const std::uint32_t value = loadLe32(contents.data() + offset);
+        return swapped ? swapBytes(value) : value;
+    };
+    linkType = field(20) & 0xffff;
+
+    for (std::size_t offset = fileHeaderBytes; offset < contents.size();) {
+        if (contents.size() - offset < recordHeaderBytes) {
+            throw std::runtime_error("truncated capture file: " + path);
+        }
+        const std::uint64_t seconds = field(offset);
+        const std::uint64_t fraction = field(offset + 4);
+        const std::uint32_t included = field(offset + 8);
+        const std::uint32_t original = field(offset + 12);
+        offset += recordHeaderBytes;
+        if (contents.size() - offset < included) {
+            throw std::runtime_error("truncated capture file: " + path);
+        }
+        packets.push_back({seconds * 1'000'000'000 + fraction * fractionNs, original,
+                           {contents.data() + offset, included}});
+        offset += included;
+    }
+}
+// End PcapReader Implementations
+
+// Begin PcapWriter Implementations
+PcapWriter::PcapWriter(const std::string& path, std::uint32_t linkType,
+                       std::uint32_t snapLength)
+    : out{path, std::ios::binary | std::ios::trunc},
+      path{path},
+      snapLength{snapLength} {
+    if (!out) {
+        throw std::runtime_error("cannot open capture file for writing: " + path);
+    }
+    std::uint8_t header[fileHeaderBytes] = {};
+    storeLe32(header, magicNanoseconds);
+    header[4] = 2; // version 2.4
+    header[6] = 4;
+    storeLe32(header + 16, snapLength);
+    storeLe32(header + 20, linkType);
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+}
+
+void PcapWriter::write(std::uint64_t timestampNs, std::span<const std::uint8_t> data,
+                       std::uint32_t originalLength) {
+    const auto included =
+        static_cast<std::uint32_t>(std::min<std::size_t>(data.size(), snapLength));
+    std::uint8_t header[recordHeaderBytes];
+    storeLe32(header, static_cast<std::uint32_t>(timestampNs / 1'000'000'000));
+    storeLe32(header + 4, static_cast<std::uint32_t>(timestampNs % 1'000'000'000));
+    storeLe32(header + 8, included);
+    storeLe32(header + 12, originalLength != 0 ? originalLength
+                                               : static_cast<std::uint32_t>(data.size()));
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(data.data()), included);
+    if (!out) {
+        throw std::runtime_error("failed writing capture file: " + path);
+    }
+}
+
+void PcapWriter::flush() {
+    out.flush();
+}
+// End PcapWriter Implementations
+
+} // namespace vsc
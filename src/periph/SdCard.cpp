@@ -0,0 +1,947 @@
+/** @file
+ * SD card model implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "VSC/periph/SdCard.h"
+#include "VSC/util/Crc.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr std::uint32_t ocrPoweredUp = 1u << 31;
+constexpr std::uint32_t ocrValue = 0x40ff8000; // high capacity, 2.7-3.6 V
+constexpr std::uint16_t cardRca = 0x0001;
+
+// card status bits (native R1)
+constexpr std::uint32_t outOfRange = 1u << 31;
+constexpr std::uint32_t addressError = 1u << 30;
+constexpr std::uint32_t blockLenError = 1u << 29;
+constexpr std::uint32_t wpViolation = 1u << 26;
+constexpr std::uint32_t comCrcError = 1u << 23;
+constexpr std::uint32_t illegalCommand = 1u << 22;
+constexpr std::uint32_t readyForData = 1u << 8;
+constexpr std::uint32_t appCmd = 1u << 5;
+
+// SPI R1 bits
+constexpr std::uint8_t r1Idle = 0x01;
+constexpr std::uint8_t r1IllegalCommand = 0x04;
+constexpr std::uint8_t r1CrcError = 0x08;
+constexpr std::uint8_t r1AddressError = 0x20;
+constexpr std::uint8_t r1ParameterError = 0x40;
+
+// SPI data tokens
+constexpr std::uint8_t startBlockToken = 0xfe;
+constexpr std::uint8_t startMultiWriteToken = 0xfc;
+constexpr std::uint8_t stopTranToken = 0xfd;
+constexpr std::uint8_t outOfRangeToken = 0x08;
+
+// CRC status / data response codes
+constexpr unsigned writeAccepted = 0b010;
+constexpr unsigned writeCrcError = 0b101;
+constexpr unsigned writeError = 0b110;
+
+constexpr unsigned ncrClocks = 2;
+
+/**
+ * CRC7 of commands, responses and the CID/CSD registers.
+ */
+std::uint8_t crc7(const std::uint8_t* data, std::size_t size) {
+    return static_cast<std::uint8_t>(crcFor<crc7Mmc>().compute({data, size}));
+}
+
+/**
+ * CRC16 of data blocks.
+ */
+std::uint16_t crc16(const std::uint8_t* data, std::size_t size) {
+    return static_cast<std::uint16_t>(crcFor<crc16Xmodem>().compute({data, size}));
+}
+
+/**
+ * CRC16 of each DAT line. In 4-bit mode every line carries one bit of each nibble, so
+ * the lines are separated into bytes first and each is checked with the byte table.
+ */
+std::array<std::uint16_t, 4> lineCrcs(const std::uint8_t* data, std::size_t size,
+                                      bool wide) {
+    std::array<std::uint16_t, 4> crcs{};
+    if (!wide) {
+        crcs[0] = crc16(data, size);
+        return crcs;
+    }
+    std::array<std::array<std::uint8_t, SdCard::blockBytes / 4>, 4> lines;
+    std::array<unsigned, 4> shift{};
+    for (std::size_t i = 0; i < size; ++i) {
+        const unsigned high = data[i] >> 4;
+        const unsigned low = data[i] & 0xf;
+        for (unsigned line = 0; line < 4; ++line) {
+            shift[line] = (shift[line] << 2) | (((high >> line) & 1) << 1) |
+                          ((low >> line) & 1);
+        }
+        if ((i & 3) == 3) {
+            for (unsigned line = 0; line < 4; ++line) {
+                lines[line][i / 4] = static_cast<std::uint8_t>(shift[line]);
+            }
+        }
+    }
+    for (unsigned line = 0; line < 4; ++line) {
+        crcs[line] = crc16(lines[line].data(), size / 4);
+    }
+    return crcs;
+}
+
+void storeBigEndian(std::uint8_t* out, std::uint32_t value) {
+    out[0] = static_cast<std::uint8_t>(value >> 24);
+    out[1] = static_cast<std::uint8_t>(value >> 16);
+    out[2] = static_cast<std::uint8_t>(value >> 8);
+    out[3] = static_cast<std::uint8_t>(value);
+}
+
+} // namespace
+
+// Begin SdCard Implementations
+SdCard::SdCard(const std::string& imagePath, const SdCardOptions& options)
+    : image{nullptr},
+      imageBytes{0},
+      blockCount{0},
+      options{options},
+      stats{},
+      cid{},
+      csd{},
+      registerData{},
+      registerBytes{0},
+      block{},
+      writeCount{0},
+      lastClk{false},
+      pins{},
+      cmdShift{0},
+      cmdBits{0},
+      response{},
+      responseBits{0},
+      responsePos{0},
+      responseDelay{0},
+      busyAfterResponse{false},
+      busyClocks{0},
+      frameLength{0},
+      framePos{0},
+      frameDelay{0},
+      lineCrc{},
+      spiLastClk{false},
+      spiSelected{false},
+      spiBits{0},
+      spiInShift{0},
+      spiOutShift{0xff},
+      spiNext{0xff},
+      spiCommand{},
+      spiCommandBytes{0},
+      spiOutLength{0},
+      spiOutPos{0},
+      spiBusy{0} {
+    const int fd = ::open(imagePath.c_str(), options.writeBack ? O_RDWR : O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open SD image " + imagePath + ": " +
+                                 std::strerror(errno));
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0 || info.st_size <= 0 ||
+        info.st_size % static_cast<off_t>(blockBytes) != 0) {
+        ::close(fd);
+        throw std::runtime_error("SD image " + imagePath +
+                                 " must be a non-empty multiple of 512 bytes");
+    }
+    imageBytes = static_cast<std::size_t>(info.st_size);
+    blockCount = imageBytes / blockBytes;
+    // a private mapping keeps the image file unchanged while the card is written
+    void* mapping = ::mmap(nullptr, imageBytes, PROT_READ | PROT_WRITE,
+                           options.writeBack ? MAP_SHARED : MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("cannot map SD image " + imagePath + ": " +
+                                 std::strerror(errno));
+    }
+    image = static_cast<std::uint8_t*>(mapping);
+
+    // CID: manufacturer, OEM "VS", product "VSCSD", revision 1.0, serial, date
+    cid = {0x1d, 'V', 'S', 'V', 'S', 'C', 'S', 'D', 0x10, 0x12, 0x34, 0x56, 0x78, 0x01,
+           0x8a, 0x00};
+    cid[15] = static_cast<std::uint8_t>(crc7(cid.data(), 15) << 1 | 1);
+    // CSD version 2.0, capacity (C_SIZE + 1) * 512 KiB
+    const std::uint32_t cSize =
+        static_cast<std::uint32_t>(std::max<std::uint64_t>(blockCount / 1024, 1) - 1);
+    csd = {0x40,
+           0x0e,
+           0x00,
+           0x32, // 25 MHz
+           0x5b,
+           0x59, // command classes, 512 byte reads
+           0x00,
+           static_cast<std::uint8_t>((cSize >> 16) & 0x3f),
+           static_cast<std::uint8_t>(cSize >> 8),
+           static_cast<std::uint8_t>(cSize),
+           0x7f,
+           0x80,
+           0x0a,
+           0x40, // 512 byte writes
+           0x00,
+           0x00};
+    csd[15] = static_cast<std::uint8_t>(crc7(csd.data(), 15) << 1 | 1);
+    resetCard();
+}
+
+SdCard::~SdCard() {
+    ::munmap(image, imageBytes);
+}
+
+void SdCard::resetCard() {
+    state = State::Idle;
+    initialized = false;
+    appCommand = false;
+    wideBus = false;
+    spiCrc = false;
+    rca = 0;
+    errorBits = 0;
+    eraseStart = 0;
+    eraseEnd = 0;
+    stopTransfer();
+}
+
+void SdCard::stopTransfer() {
+    transfer = Transfer::None;
+    multiBlock = false;
+    nextBlock = 0;
+    registerBytes = 0;
+    writePhase = WritePhase::Token;
+    frameLength = 0;
+    framePos = 0;
+    frameDelay = 0;
+    pins.dat = 0xf;
+    pins.datEnable = 0;
+    spiOutLength = 0;
+    spiOutPos = 0;
+}
+
+std::uint32_t SdCard::cardStatus(State reported) {
+    std::uint32_t status = errorBits | static_cast<std::uint32_t>(reported) << 9;
+    if (reported == State::Transfer) {
+        status |= readyForData;
+    }
+    if (appCommand) {
+        status |= appCmd;
+    }
+    errorBits = 0; // error bits are cleared once reported
+    return status;
+}
+
+std::uint8_t SdCard::spiR1() {
+    std::uint8_t r1 = initialized ? 0 : r1Idle;
+    if (errorBits & illegalCommand) {
+        r1 |= r1IllegalCommand;
+    }
+    if (errorBits & comCrcError) {
+        r1 |= r1CrcError;
+    }
+    if (errorBits & (addressError | outOfRange | wpViolation)) {
+        r1 |= r1AddressError;
+    }
+    if (errorBits & blockLenError) {
+        r1 |= r1ParameterError;
+    }
+    errorBits = 0;
+    return r1;
+}
+
+SdCard::Reply SdCard::executeApp(unsigned index, std::uint32_t argument, bool spi,
+                                 bool& handled) {
+    handled = true;
+    switch (index) {
+        case 6: // SET_BUS_WIDTH
+            if (state == State::Transfer) {
+                wideBus = (argument & 3) == 2;
+                return {Response::R1, 0, nullptr};
+            }
+            break;
+        case 13: // SD_STATUS
+            if (state == State::Transfer) {
+                registerData.fill(0);
+                registerData[0] = wideBus ? 0x80 : 0x00;
+                startRegisterRead(64);
+                return {spi ? Response::R2 : Response::R1, 0, nullptr};
+            }
+            break;
+        case 23: // SET_WR_BLK_ERASE_COUNT, only a hint
+        case 42: // SET_CLR_CARD_DETECT
+            return {Response::R1, 0, nullptr};
+        case 41: // SD_SEND_OP_COND
+            if (spi) {
+                initialized = true;
+                state = State::Transfer;
+                return {Response::R1, 0, nullptr};
+            }
+            if (state != State::Idle && state != State::Ready) {
+                break;
+            }
+            if ((argument & 0x00ff8000) != 0) { // not just an inquiry
+                initialized = true;
+                state = State::Ready;
+            }
+            return {Response::R3, initialized ? ocrValue | ocrPoweredUp : ocrValue,
+                    nullptr};
+        case 51: // SEND_SCR: SD 3.0, 1 and 4 bit bus widths
+            if (state == State::Transfer) {
+                registerData.fill(0);
+                registerData[0] = 0x02;
+                registerData[1] = 0x35;
+                registerData[2] = 0x80;
+                startRegisterRead(8);
+                return {Response::R1, 0, nullptr};
+            }
+            break;
+        default:
+            break;
+    }
+    handled = false; // unknown application commands are regular commands
+    return {Response::None, 0, nullptr};
+}
+
+SdCard::Reply SdCard::execute(unsigned index, std::uint32_t argument, bool spi) {
+    ++stats.commands;
+    const State before = state;
+    Reply reply{Response::None, 0, nullptr};
+    bool handled = false;
+    if (appCommand) {
+        reply = executeApp(index, argument, spi, handled);
+        appCommand = false;
+    }
+    if (!handled) {
+        handled = true;
+        switch (index) {
+            case 0: // GO_IDLE_STATE
+                resetCard();
+                reply = {spi ? Response::R1 : Response::None, 0, nullptr};
+                break;
+            case 2: // ALL_SEND_CID
+                if (state != State::Ready) {
+                    handled = false;
+                    break;
+                }
+                state = State::Ident;
+                reply = {Response::R2, 0, cid.data()};
+                break;
+            case 3: // SEND_RELATIVE_ADDR
+                if (state != State::Ident && state != State::Standby) {
+                    handled = false;
+                    break;
+                }
+                rca = cardRca;
+                state = State::Standby;
+                reply = {Response::R6, 0, nullptr};
+                break;
+            case 6: // SWITCH_FUNC: only the default functions
+                if (state != State::Transfer) {
+                    handled = false;
+                    break;
+                }
+                registerData.fill(0);
+                registerData[1] = 100; // mA
+                for (std::size_t group = 0; group < 6; ++group) {
+                    registerData[2 + 2 * group] = 0x80;
+                    registerData[3 + 2 * group] = 0x01;
+                }
+                startRegisterRead(64);
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 7: // SELECT/DESELECT_CARD
+                if (rca != 0 && (argument >> 16) == rca) {
+                    if (state == State::Standby) {
+                        state = State::Transfer;
+                    }
+                    reply = {Response::R1b, 0, nullptr};
+                } else if (state == State::Transfer) {
+                    state = State::Standby; // deselected cards do not respond
+                }
+                break;
+            case 8: // SEND_IF_COND
+                reply = {Response::R7, argument & 0xfff, nullptr};
+                break;
+            case 9:  // SEND_CSD
+            case 10: // SEND_CID
+            {
+                const auto& value = index == 9 ? csd : cid;
+                if (spi) {
+                    std::copy(value.begin(), value.end(), registerData.begin());
+                    startRegisterRead(value.size());
+                    reply = {Response::R1, 0, nullptr};
+                } else if (state == State::Standby) {
+                    reply = {Response::R2, 0, value.data()};
+                } else {
+                    handled = false;
+                }
+                break;
+            }
+            case 12: // STOP_TRANSMISSION
+                stopTransfer();
+                if (state == State::Data || state == State::Receive) {
+                    state = State::Transfer;
+                }
+                reply = {Response::R1b, 0, nullptr};
+                break;
+            case 13: // SEND_STATUS
+                reply = {spi ? Response::R2 : Response::R1, 0, nullptr};
+                break;
+            case 16: // SET_BLOCKLEN, fixed for high capacity cards
+                if (argument != blockBytes) {
+                    errorBits |= blockLenError;
+                }
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 17: // READ_SINGLE_BLOCK
+            case 18: // READ_MULTIPLE_BLOCK
+                if (state != State::Transfer) {
+                    handled = false;
+                    break;
+                }
+                startRead(argument, index == 18);
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 23: // SET_BLOCK_COUNT, transfers end with CMD12 or the stop token
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 24: // WRITE_BLOCK
+            case 25: // WRITE_MULTIPLE_BLOCK
+                if (state != State::Transfer) {
+                    handled = false;
+                    break;
+                }
+                startWrite(argument, index == 25);
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 32: // ERASE_WR_BLK_START
+                eraseStart = argument;
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 33: // ERASE_WR_BLK_END
+                eraseEnd = argument;
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 38: // ERASE
+                if (options.writeProtect) {
+                    errorBits |= wpViolation;
+                } else if (eraseStart > eraseEnd || eraseEnd >= blockCount) {
+                    errorBits |= outOfRange;
+                } else {
+                    std::memset(image + eraseStart * blockBytes, 0,
+                                (eraseEnd - eraseStart + 1) * blockBytes);
+                }
+                reply = {Response::R1b, 0, nullptr};
+                break;
+            case 55: // APP_CMD
+                appCommand = true;
+                reply = {Response::R1, 0, nullptr};
+                break;
+            case 58: // READ_OCR (SPI)
+                handled = spi;
+                reply = {Response::R3, initialized ? ocrValue | ocrPoweredUp : ocrValue,
+                         nullptr};
+                break;
+            case 59: // CRC_ON_OFF (SPI)
+                handled = spi;
+                spiCrc = (argument & 1) != 0;
+                reply = {Response::R1, 0, nullptr};
+                break;
+            default:
+                handled = false;
+                break;
+        }
+    }
+    if (!handled) {
+        errorBits |= illegalCommand;
+        return {spi ? Response::R1 : Response::None, 0, nullptr};
+    }
+    // native responses report the state the card was in when the command arrived
+    if (!spi) {
+        if (reply.kind == Response::R1 || reply.kind == Response::R1b) {
+            reply.value = cardStatus(before);
+        } else if (reply.kind == Response::R6) {
+            const std::uint32_t status = cardStatus(before);
+            reply.value = static_cast<std::uint32_t>(rca) << 16 |
+                          ((status >> 8) & 0xc000) | ((status >> 6) & 0x2000) |
+                          (status & 0x1fff);
+        }
+    }
+    return reply;
+}
+
+bool SdCard::startRead(std::uint64_t address, bool multi) {
+    if (address >= blockCount) {
+        errorBits |= outOfRange;
+        return false;
+    }
+    transfer = Transfer::ReadBlocks;
+    multiBlock = multi;
+    nextBlock = address;
+    state = State::Data;
+    return true;
+}
+
+bool SdCard::startWrite(std::uint64_t address, bool multi) {
+    if (options.writeProtect) {
+        errorBits |= wpViolation;
+        return false;
+    }
+    if (address >= blockCount) {
+        errorBits |= outOfRange;
+        return false;
+    }
+    transfer = Transfer::WriteBlocks;
+    multiBlock = multi;
+    nextBlock = address;
+    writePhase = WritePhase::Token;
+    state = State::Receive;
+    return true;
+}
+
+void SdCard::startRegisterRead(std::size_t bytes) {
+    transfer = Transfer::ReadRegister;
+    registerBytes = bytes;
+    state = State::Data;
+}
+
+unsigned SdCard::commitWrite(bool crcValid) {
+    if (!crcValid) {
+        ++stats.crcErrors;
+        return writeCrcError;
+    }
+    if (nextBlock >= blockCount) {
+        errorBits |= outOfRange;
+        return writeError;
+    }
+    std::memcpy(image + nextBlock * blockBytes, block.data(), blockBytes);
+    ++nextBlock;
+    ++stats.blocksWritten;
+    return writeAccepted;
+}
+
+void SdCard::endBusy() {
+    if (transfer == Transfer::WriteBlocks && writePhase == WritePhase::End) {
+        if (multiBlock) {
+            writePhase = WritePhase::Token;
+        } else {
+            transfer = Transfer::None;
+            state = State::Transfer;
+        }
+    }
+}
+
+// native mode
+void SdCard::nativeRising(bool cmd, std::uint8_t dat) {
+    if (!pins.cmdEnable && responseBits == 0) {
+        if (cmdBits == 0) {
+            if (!cmd) { // start bit
+                cmdShift = 0;
+                cmdBits = 1;
+            }
+        } else {
+            cmdShift = (cmdShift << 1) | (cmd ? 1 : 0);
+            if (++cmdBits == 48) {
+                cmdBits = 0;
+                nativeCommand(cmdShift);
+            }
+        }
+    }
+    if (transfer == Transfer::WriteBlocks && pins.datEnable == 0) {
+        receiveNative(dat);
+    }
+}
+
+void SdCard::nativeCommand(std::uint64_t bits) {
+    std::uint8_t bytes[5];
+    for (int i = 0; i < 5; ++i) {
+        bytes[i] = static_cast<std::uint8_t>(bits >> (40 - 8 * i));
+    }
+    const bool fromHost = (bits >> 46) & 1;
+    if (!fromHost || crc7(bytes, 5) != ((bits >> 1) & 0x7f)) {
+        errorBits |= comCrcError; // no response, reported with the next status
+        return;
+    }
+    const unsigned index = (bits >> 40) & 0x3f;
+    const Reply reply = execute(index, static_cast<std::uint32_t>(bits >> 8), false);
+
+    switch (reply.kind) {
+        case Response::None:
+            return;
+        case Response::R2:
+            response[0] = 0x3f;
+            std::copy_n(reply.longValue, 16, response.begin() + 1);
+            responseBits = 136;
+            break;
+        case Response::R3:
+            response[0] = 0x3f;
+            storeBigEndian(&response[1], reply.value);
+            response[5] = 0xff;
+            responseBits = 48;
+            break;
+        default:
+            response[0] = static_cast<std::uint8_t>(index);
+            storeBigEndian(&response[1], reply.value);
+            response[5] = static_cast<std::uint8_t>(crc7(response.data(), 5) << 1 | 1);
+            responseBits = 48;
+            break;
+    }
+    responsePos = 0;
+    responseDelay = ncrClocks;
+    busyAfterResponse = reply.kind == Response::R1b;
+
+    if ((transfer == Transfer::ReadBlocks || transfer == Transfer::ReadRegister) &&
+        frameLength == 0 && nextNativeFrame()) {
+        frameDelay = ncrClocks + responseBits + options.accessDelay;
+    }
+}
+
+void SdCard::buildNativeFrame(const std::uint8_t* data, std::size_t bytes) {
+    std::size_t n = 0;
+    frame[n++] = wideBus ? 0x0 : 0xe; // start bit
+    if (wideBus) {
+        for (std::size_t i = 0; i < bytes; ++i) {
+            frame[n++] = data[i] >> 4;
+            frame[n++] = data[i] & 0xf;
+        }
+    } else {
+        for (std::size_t i = 0; i < bytes; ++i) {
+            for (int bit = 7; bit >= 0; --bit) {
+                frame[n++] = static_cast<std::uint8_t>(0xe | ((data[i] >> bit) & 1));
+            }
+        }
+    }
+    const auto crcs = lineCrcs(data, bytes, wideBus);
+    for (int bit = 15; bit >= 0; --bit) {
+        std::uint8_t symbol = wideBus ? 0x0 : 0xe;
+        for (unsigned line = 0; line < (wideBus ? 4u : 1u); ++line) {
+            symbol |= static_cast<std::uint8_t>(((crcs[line] >> bit) & 1) << line);
+        }
+        frame[n++] = symbol;
+    }
+    frame[n++] = 0xf; // end bit
+    frameLength = n;
+    framePos = 0;
+}
+
+bool SdCard::nextNativeFrame() {
+    if (transfer == Transfer::ReadRegister) {
+        if (registerBytes == 0) {
+            return false;
+        }
+        buildNativeFrame(registerData.data(), registerBytes);
+        registerBytes = 0;
+        return true;
+    }
+    if (transfer != Transfer::ReadBlocks) {
+        return false;
+    }
+    if (nextBlock >= blockCount) {
+        errorBits |= outOfRange;
+        return false;
+    }
+    buildNativeFrame(image + nextBlock * blockBytes, blockBytes);
+    ++nextBlock;
+    ++stats.blocksRead;
+    return true;
+}
+
+void SdCard::receiveNative(std::uint8_t dat) {
+    const unsigned lines = wideBus ? 4 : 1;
+    switch (writePhase) {
+        case WritePhase::Token:
+            if ((dat & 1) == 0) { // start bit
+                writePhase = WritePhase::Data;
+                writeCount = 0;
+                lineCrc.fill(0);
+            }
+            break;
+        case WritePhase::Data:
+            if (wideBus) {
+                std::uint8_t& byte = block[writeCount / 2];
+                byte = (writeCount & 1) ? static_cast<std::uint8_t>(byte | (dat & 0xf))
+                                        : static_cast<std::uint8_t>(dat << 4);
+            } else {
+                std::uint8_t& byte = block[writeCount / 8];
+                byte = static_cast<std::uint8_t>(byte << 1 | (dat & 1));
+            }
+            if (++writeCount == blockBytes * 8 / lines) {
+                writePhase = WritePhase::Crc;
+                writeCount = 0;
+            }
+            break;
+        case WritePhase::Crc:
+            for (unsigned line = 0; line < lines; ++line) {
+                lineCrc[line] =
+                    static_cast<std::uint16_t>(lineCrc[line] << 1 | ((dat >> line) & 1));
+            }
+            if (++writeCount == 16) {
+                writePhase = WritePhase::End;
+                const auto expected = lineCrcs(block.data(), blockBytes, wideBus);
+                bool valid = true;
+                for (unsigned line = 0; line < lines; ++line) {
+                    valid = valid && expected[line] == lineCrc[line];
+                }
+                // CRC status on DAT0 after two clocks: start, status, end
+                const unsigned status = commitWrite(valid);
+                const std::uint8_t symbols[] = {0xf, 0xf, 0xe, 0, 0, 0, 0xf};
+                std::copy(std::begin(symbols), std::end(symbols), frame.begin());
+                for (int bit = 0; bit < 3; ++bit) {
+                    frame[3 + bit] =
+                        static_cast<std::uint8_t>(0xe | ((status >> (2 - bit)) & 1));
+                }
+                frameLength = std::size(symbols);
+                framePos = 0;
+                frameDelay = 0;
+            }
+            break;
+        case WritePhase::End:
+            break; // the end bit, then the card owns DAT0 until it is no longer busy
+    }
+}
+
+void SdCard::nativeFalling() {
+    if (responseBits != 0) {
+        if (responseDelay > 0) {
+            --responseDelay;
+        } else if (responsePos < responseBits) {
+            pins.cmd = (response[responsePos / 8] >> (7 - responsePos % 8)) & 1;
+            pins.cmdEnable = true;
+            ++responsePos;
+        } else {
+            pins.cmd = true;
+            pins.cmdEnable = false;
+            responseBits = 0;
+            if (busyAfterResponse) {
+                busyAfterResponse = false;
+                busyClocks = options.busyDelay;
+            }
+        }
+    }
+
+    if (busyClocks > 0) {
+        pins.dat = 0xe; // DAT0 low
+        pins.datEnable = 0x1;
+        if (--busyClocks == 0) {
+            endBusy();
+        }
+        return;
+    }
+    if (frameLength == 0) {
+        pins.dat = 0xf;
+        pins.datEnable = 0;
+        return;
+    }
+    if (frameDelay > 0) {
+        --frameDelay;
+        return;
+    }
+    if (framePos < frameLength) {
+        pins.dat = frame[framePos++];
+        pins.datEnable = transfer == Transfer::WriteBlocks || !wideBus ? 0x1 : 0xf;
+        return;
+    }
+
+    // frame complete
+    frameLength = 0;
+    pins.dat = 0xf;
+    pins.datEnable = 0;
+    if (transfer == Transfer::WriteBlocks) {
+        busyClocks = options.busyDelay;
+        if (busyClocks == 0) {
+            endBusy();
+        }
+    } else if (transfer == Transfer::ReadBlocks && multiBlock && nextNativeFrame()) {
+        frameDelay = options.accessDelay;
+    } else {
+        transfer = Transfer::None;
+        if (state == State::Data) {
+            state = State::Transfer;
+        }
+    }
+}
+
+// SPI mode
+bool SdCard::spiStep(bool sclk, bool csn, bool mosi) {
+    if (csn) {
+        spiSelected = false;
+        spiLastClk = sclk;
+        return true;
+    }
+    if (!spiSelected) {
+        spiSelected = true;
+        spiBits = 0;
+        spiOutShift = spiNext;
+    }
+    if (sclk != spiLastClk) {
+        spiLastClk = sclk;
+        if (sclk) {
+            spiInShift = static_cast<std::uint8_t>(spiInShift << 1 | (mosi ? 1 : 0));
+            if (++spiBits == 8) {
+                spiBits = 0;
+                spiNext = spiProcess(spiInShift);
+                spiOutShift = spiNext;
+            }
+        } else if (spiBits != 0) {
+            spiOutShift = static_cast<std::uint8_t>(spiOutShift << 1);
+        }
+    }
+    return (spiOutShift & 0x80) != 0;
+}
+
+std::uint8_t SdCard::spiProcess(std::uint8_t in) {
+    const bool isToken =
+        in == startBlockToken || in == startMultiWriteToken || in == stopTranToken;
+    const bool receiving =
+        transfer == Transfer::WriteBlocks &&
+        (writePhase == WritePhase::Data ||
+         (writePhase == WritePhase::Token && spiOutPos >= spiOutLength && isToken));
+    if (receiving) {
+        receiveSpi(in);
+    } else if (spiCommandBytes > 0 || (in & 0xc0) == 0x40) {
+        spiCommand[spiCommandBytes++] = in;
+        if (spiCommandBytes == spiCommand.size()) {
+            spiCommandBytes = 0;
+            if (spiCrc && crc7(spiCommand.data(), 5) != spiCommand[5] >> 1) {
+                errorBits |= comCrcError;
+                spiQueueReply({Response::R1, 0, nullptr});
+            } else {
+                const std::uint32_t argument =
+                    static_cast<std::uint32_t>(spiCommand[1]) << 24 |
+                    static_cast<std::uint32_t>(spiCommand[2]) << 16 |
+                    static_cast<std::uint32_t>(spiCommand[3]) << 8 | spiCommand[4];
+                spiQueueReply(execute(spiCommand[0] & 0x3f, argument, true));
+            }
+        }
+    }
+
+    if (spiOutPos < spiOutLength) {
+        return spiOut[spiOutPos++];
+    }
+    if (spiBusy > 0) {
+        if (--spiBusy == 0) {
+            endBusy();
+        }
+        return 0x00;
+    }
+    if (nextSpiFrame()) {
+        return spiOut[spiOutPos++];
+    }
+    return 0xff;
+}
+
+void SdCard::spiQueueReply(const Reply& reply) {
+    std::size_t n = 0;
+    spiOut[n++] = 0xff; // NCR
+    spiOut[n++] = spiR1();
+    switch (reply.kind) {
+        case Response::R2:
+            spiOut[n++] = 0x00;
+            break;
+        case Response::R3:
+        case Response::R7:
+            storeBigEndian(&spiOut[n], reply.value);
+            n += 4;
+            break;
+        case Response::R1b:
+            spiBusy = std::max(options.busyDelay, 1u);
+            break;
+        default:
+            break;
+    }
+    spiOutLength = n;
+    spiOutPos = 0;
+}
+
+void SdCard::spiQueueData(const std::uint8_t* data, std::size_t bytes) {
+    std::size_t n = 0;
+    for (unsigned i = 0; i < std::min(options.accessDelay, 64u); ++i) {
+        spiOut[n++] = 0xff;
+    }
+    spiOut[n++] = startBlockToken;
+    std::memcpy(&spiOut[n], data, bytes);
+    n += bytes;
+    const std::uint16_t crc = crc16(data, bytes);
+    spiOut[n++] = static_cast<std::uint8_t>(crc >> 8);
+    spiOut[n++] = static_cast<std::uint8_t>(crc);
+    spiOutLength = n;
+    spiOutPos = 0;
+}
+
+bool SdCard::nextSpiFrame() {
+    if (transfer == Transfer::ReadRegister) {
+        if (registerBytes == 0) {
+            transfer = Transfer::None;
+            state = State::Transfer;
+            return false;
+        }
+        spiQueueData(registerData.data(), registerBytes);
+        registerBytes = 0;
+        return true;
+    }
+    if (transfer != Transfer::ReadBlocks) {
+        return false;
+    }
+    if (nextBlock >= blockCount) {
+        errorBits |= outOfRange;
+        transfer = Transfer::None;
+        state = State::Transfer;
+        spiOut[0] = outOfRangeToken;
+        spiOutLength = 1;
+        spiOutPos = 0;
+        return true;
+    }
+    spiQueueData(image + nextBlock * blockBytes, blockBytes);
+    ++nextBlock;
+    ++stats.blocksRead;
+    if (!multiBlock) {
+        transfer = Transfer::None;
+        state = State::Transfer;
+    }
+    return true;
+}
+
+void SdCard::receiveSpi(std::uint8_t in) {
+    if (writePhase == WritePhase::Token) {
+        if (in == startBlockToken || (multiBlock && in == startMultiWriteToken)) {
+            writePhase = WritePhase::Data;
+            writeCount = 0;
+        } else if (multiBlock && in == stopTranToken) {
+            transfer = Transfer::None;
+            state = State::Transfer;
+            spiBusy = std::max(options.busyDelay, 1u);
+        }
+        return;
+    }
+    block[writeCount++] = in;
+    if (writeCount < block.size()) {
+        return;
+    }
+    const bool valid =
+        !spiCrc || crc16(block.data(), blockBytes) == (block[blockBytes] << 8 |
+                                                        block[blockBytes + 1]);
+    const unsigned status = commitWrite(valid);
+    writePhase = WritePhase::End;
+    spiOut[0] = static_cast<std::uint8_t>(status << 1 | 1); // data response token
+    spiOutLength = 1;
+    spiOutPos = 0;
+    spiBusy = options.busyDelay;
+    if (spiBusy == 0) {
+        endBusy();
+    }
+}
+// End SdCard Implementations
+
+} // namespace vsc
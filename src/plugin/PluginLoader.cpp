@@ -0,0 +1,93 @@
+/** @file
+ * Model plugin loading.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <dlfcn.h>
+
+#include <stdexcept>
+
+#include "VSC/plugin/PluginLoader.h"
+
+namespace vsc {
+
+// Begin PluginLibrary Implementations
+PluginLibrary::PluginLibrary(const std::string& path)
+    : handle{nullptr},
+      api{nullptr},
+      path{path} {
+    handle = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (handle == nullptr) {
+        throw std::runtime_error("cannot load plugin: " + std::string(::dlerror()));
+    }
+    auto entry =
+        reinterpret_cast<VscModelPluginEntry>(::dlsym(handle, VSC_MODEL_PLUGIN_ENTRY));
+    if (entry == nullptr) {
+        ::dlclose(handle);
+        throw std::runtime_error(path + " is not a model plugin, " VSC_MODEL_PLUGIN_ENTRY
+                                        " is missing");
+    }
+    api = entry();
+    if (api == nullptr || api->abiVersion != VSC_MODEL_PLUGIN_ABI_VERSION ||
+        api->structSize < sizeof(VscModelPluginApi)) {
+        const unsigned version = api != nullptr ? api->abiVersion : 0;
+        ::dlclose(handle);
+        throw std::runtime_error(path + " uses plugin ABI version " +
+                                 std::to_string(version) + ", expected " +
+                                 std::to_string(VSC_MODEL_PLUGIN_ABI_VERSION));
+    }
+}
+
+PluginLibrary::~PluginLibrary() {
+    ::dlclose(handle);
+}
+// End PluginLibrary Implementations
+
+// Begin PluginModel Implementations
+PluginModel::PluginModel(const PluginLibrary& library,
+                         const std::vector<std::string>& args)
+    : api{&library.getApi()},
+      instance{nullptr} {
+    // argv[0] is the plugin, as Verilated expects a program name first
+    std::vector<const char*> argv;
+    argv.reserve(args.size() + 1);
+    argv.push_back(library.getPath().c_str());
+    for (const std::string& arg : args) {
+        argv.push_back(arg.c_str());
+    }
+    char error[256] = "";
+    instance = api->create(static_cast<int>(argv.size()), argv.data(), error,
+                           sizeof(error));
+    if (instance == nullptr) {
+        throw std::runtime_error("cannot create " + std::string(api->modelName) + ": " +
+                                 error);
+    }
+}
+
+PluginModel::~PluginModel() {
+    api->destroy(instance);
+}
+
+void PluginModel::throwLastError(const char* operation) const {
+    const char* error = api->lastError(instance);
+    throw std::runtime_error(std::string(api->modelName) + " " + operation + ": " +
+                             (error != nullptr ? error : "unknown error"));
+}
+
+void PluginModel::reset() {
+    if (api->reset(instance) != 0) {
+        throwLastError("reset failed");
+    }
+}
+
+std::uint64_t PluginModel::run(std::uint64_t cycles) {
+    const std::uint64_t done = api->run(instance, cycles);
+    if (api->lastError(instance) != nullptr) {
+        throwLastError("failed");
+    }
+    return done;
+}
+// End PluginModel Implementations
+
+} // namespace vsc
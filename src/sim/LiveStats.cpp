@@ -0,0 +1,183 @@
+/** @file
+ * Live statistics page implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+#include "VSC/sim/LiveStats.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr const char* shmPrefix = "vsc-stats.";
+constexpr const char* shmDirectory = "/dev/shm";
+constexpr int readAttempts = 64; // seqlock retries before giving up on a busy page
+
+std::int64_t nowNs() {
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(system_clock::now().time_since_epoch()).count();
+}
+
+std::optional<LiveStatsSnapshot> readPage(const LiveStatsPage& page) {
+    for (int attempt = 0; attempt < readAttempts; ++attempt) {
+        const std::uint64_t before = page.sequence.load(std::memory_order_acquire);
+        if (before == 0) {
+            return std::nullopt; // not set up yet
+        }
+        if (before & 1) {
+            continue; // writer active
+        }
+        LiveStatsSnapshot snapshot;
+        snapshot.cycles = page.cycles.load(std::memory_order_relaxed);
+        snapshot.transactions = page.transactions.load(std::memory_order_relaxed);
+        snapshot.errors = page.errors.load(std::memory_order_relaxed);
+        snapshot.cyclesPerSecond = std::bit_cast<double>(
+            page.cyclesPerSecondBits.load(std::memory_order_relaxed));
+        const std::int64_t updateNs = page.updateNs.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page.sequence.load(std::memory_order_relaxed) != before) {
+            continue;
+        }
+        if (page.magic != LiveStatsPage::pageMagic) {
+            return std::nullopt;
+        }
+        snapshot.pid = page.pid;
+        snapshot.name.assign(page.name, strnlen(page.name, LiveStatsPage::nameBytes));
+        const std::int64_t now = nowNs();
+        snapshot.uptimeSeconds = static_cast<double>(now - page.startNs) * 1e-9;
+        snapshot.secondsSinceUpdate = static_cast<double>(now - updateNs) * 1e-9;
+        snapshot.alive = ::kill(static_cast<pid_t>(page.pid), 0) == 0 || errno == EPERM;
+        return snapshot;
+    }
+    return std::nullopt;
+}
+
+} // namespace
+
+// Begin LiveStatsPublisher Implementations
+LiveStatsPublisher::LiveStatsPublisher(const std::string& name,
+                                       std::uint64_t intervalCycles)
+    : page{nullptr},
+      interval{std::max<std::uint64_t>(intervalCycles, 1)},
+      nextPublish{0},
+      transactions{0},
+      errors{0},
+      lastCycles{0},
+      lastNs{nowNs()} {
+    static std::atomic<unsigned> nextIndex{0};
+    shmName = std::string("/") + shmPrefix + std::to_string(::getpid()) + "." +
+              std::to_string(nextIndex.fetch_add(1));
+
+    const int fd = ::shm_open(shmName.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC,
+                              0644);
+    if (fd < 0) {
+        throw std::runtime_error("cannot create live stats page: " + shmName);
+    }
+    if (::ftruncate(fd, sizeof(LiveStatsPage)) != 0) {
+        ::close(fd);
+        ::shm_unlink(shmName.c_str());
+        throw std::runtime_error("cannot size live stats page: " + shmName);
+    }
+    void* mapping = ::mmap(nullptr, sizeof(LiveStatsPage), PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        ::shm_unlink(shmName.c_str());
+        throw std::runtime_error("cannot map live stats page: " + shmName);
+    }
+
+    // the fresh mapping is zero filled, so sequence starts out at "not set up"
+    page = new (mapping) LiveStatsPage{};
+    page->magic = LiveStatsPage::pageMagic;
+    page->pid = ::getpid();
+    std::strncpy(page->name, name.c_str(), LiveStatsPage::nameBytes - 1);
+    page->startNs = lastNs;
+    publish(0); // releases the header along with the first counters
+}
+
+LiveStatsPublisher::~LiveStatsPublisher() {
+    ::munmap(page, sizeof(LiveStatsPage));
+    ::shm_unlink(shmName.c_str());
+}
+
+void LiveStatsPublisher::publish(std::uint64_t cycles) {
+    const std::int64_t now = nowNs();
+    double rate = std::bit_cast<double>(
+        page->cyclesPerSecondBits.load(std::memory_order_relaxed));
+    if (now > lastNs && cycles >= lastCycles) {
+        rate = static_cast<double>(cycles - lastCycles) * 1e9 /
+               static_cast<double>(now - lastNs);
+    }
+    lastCycles = cycles;
+    lastNs = now;
+    nextPublish = cycles + interval;
+
+    // only this publisher writes the page, so a relaxed read of sequence is enough
+    const std::uint64_t sequence = page->sequence.load(std::memory_order_relaxed);
+    page->sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    page->cycles.store(cycles, std::memory_order_relaxed);
+    page->transactions.store(transactions, std::memory_order_relaxed);
+    page->errors.store(errors, std::memory_order_relaxed);
+    page->cyclesPerSecondBits.store(std::bit_cast<std::uint64_t>(rate),
+                                    std::memory_order_relaxed);
+    page->updateNs.store(now, std::memory_order_relaxed);
+    page->sequence.store(sequence + 2, std::memory_order_release);
+}
+// End LiveStatsPublisher Implementations
+
+std::vector<LiveStatsSnapshot> readAllLiveStats() {
+    std::vector<LiveStatsSnapshot> snapshots;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(shmDirectory, error)) {
+        const std::string file = entry.path().filename().string();
+        if (!file.starts_with(shmPrefix)) {
+            continue;
+        }
+        const std::string shmName = "/" + file;
+        const int fd = ::shm_open(shmName.c_str(), O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0) {
+            continue; // removed since the directory was listed
+        }
+        struct stat info;
+        if (::fstat(fd, &info) != 0 ||
+            static_cast<std::size_t>(info.st_size) < sizeof(LiveStatsPage)) {
+            ::close(fd);
+            continue;
+        }
+        void* mapping =
+            ::mmap(nullptr, sizeof(LiveStatsPage), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mapping == MAP_FAILED) {
+            continue;
+        }
+        if (auto snapshot = readPage(*static_cast<const LiveStatsPage*>(mapping))) {
+            snapshots.push_back(std::move(*snapshot));
+        }
+        ::munmap(mapping, sizeof(LiveStatsPage));
+    }
+    std::sort(snapshots.begin(), snapshots.end(), [](const auto& a, const auto& b) {
+        return a.pid != b.pid ? a.pid < b.pid : a.name < b.name;
+    });
+    return snapshots;
+}
+
+} // namespace vsc
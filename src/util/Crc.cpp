@@ -0,0 +1,248 @@
+/** @file
+ * CRC engine implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define VSC_CRC_X86 1
+#include <immintrin.h>
+#endif
+
+#include "VSC/util/Crc.h"
+
+namespace vsc {
+
+namespace {
+
+std::uint32_t reflect(std::uint32_t value, unsigned width) {
+    std::uint32_t result = 0;
+    for (unsigned i = 0; i < width; ++i) {
+        result |= ((value >> i) & 1) << (width - 1 - i);
+    }
+    return result;
+}
+
+std::uint32_t widthMask(unsigned width) {
+    return width == 32 ? 0xffffffff : (std::uint32_t{1} << width) - 1;
+}
+
+std::uint32_t load32Le(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) | static_cast<std::uint32_t>(p[1]) << 8 |
+           static_cast<std::uint32_t>(p[2]) << 16 |
+           static_cast<std::uint32_t>(p[3]) << 24;
+}
+
+std::uint32_t load32Be(const std::uint8_t* p) {
+    return static_cast<std::uint32_t>(p[0]) << 24 |
+           static_cast<std::uint32_t>(p[1]) << 16 |
+           static_cast<std::uint32_t>(p[2]) << 8 | static_cast<std::uint32_t>(p[3]);
+}
+
+#if VSC_CRC_X86
+__attribute__((target("sse4.2"))) std::uint32_t
+crc32cSse42(std::uint32_t state, const std::uint8_t* data, std::size_t size) {
+    std::uint64_t crc = state;
+    for (; size >= 8; size -= 8, data += 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        crc = _mm_crc32_u64(crc, word);
+    }
+    auto crc32 = static_cast<std::uint32_t>(crc);
+    for (; size > 0; --size) {
+        crc32 = _mm_crc32_u8(crc32, *data++);
+    }
+    return crc32;
+}
+
+// folding constants for the reflected CRC-32 polynomial: x^k mod P for the fold distances
+constexpr long long foldR1 = 0x154442bd4; // 4 x 128 bits, low half
+constexpr long long foldR2 = 0x1c6e41596; // 4 x 128 bits, high half
+constexpr long long foldR3 = 0x1751997d0; // 128 bits, low half
+constexpr long long foldR4 = 0x0ccaa009e; // 128 bits, high half
+constexpr long long foldR5 = 0x163cd6124; // 64 to 32 bits
+constexpr long long barrettPoly = 0x1db710641; // P, reflected
+constexpr long long barrettMu = 0x1f7011641;   // floor(x^64 / P), reflected
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i
+fold(__m128i value, __m128i constants, __m128i next) {
+    const __m128i low = _mm_clmulepi64_si128(value, constants, 0x00);
+    const __m128i high = _mm_clmulepi64_si128(value, constants, 0x11);
+    return _mm_xor_si128(_mm_xor_si128(low, high), next);
+}
+
+__attribute__((target("pclmul,sse4.1"))) inline __m128i load128(const std::uint8_t* p) {
+    return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+}
+
+/**
+ * Fold 64 bytes per step into four 128-bit remainders, merge them, then reduce to 32 bits
+ * with a Barrett reduction. size must be at least 64 and a multiple of 16.
+ */
+__attribute__((target("pclmul,sse4.1"))) std::uint32_t
+crc32Pclmul(std::uint32_t state, const std::uint8_t* data, std::size_t size) {
+    __m128i x1 = _mm_xor_si128(load128(data), _mm_cvtsi32_si128(static_cast<int>(state)));
+    __m128i x2 = load128(data + 16);
+    __m128i x3 = load128(data + 32);
+    __m128i x4 = load128(data + 48);
+    data += 64;
+    size -= 64;
+
+    __m128i constants = _mm_set_epi64x(foldR2, foldR1);
+    for (; size >= 64; size -= 64, data += 64) {
+        x1 = fold(x1, constants, load128(data));
+        x2 = fold(x2, constants, load128(data + 16));
+        x3 = fold(x3, constants, load128(data + 32));
+        x4 = fold(x4, constants, load128(data + 48));
+    }
+    constants = _mm_set_epi64x(foldR4, foldR3);
+    x1 = fold(x1, constants, x2);
+    x1 = fold(x1, constants, x3);
+    x1 = fold(x1, constants, x4);
+    for (; size >= 16; size -= 16, data += 16) {
+        x1 = fold(x1, constants, load128(data));
+    }
+
+    // 128 to 64 bits, appending 32 zero bits
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), _mm_clmulepi64_si128(x1, constants, 0x10));
+    // 64 to 32 bits
+    const __m128i mask32 = _mm_set_epi32(0, 0, 0, -1);
+    const __m128i upper = _mm_srli_si128(x1, 4);
+    x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), _mm_set_epi64x(0, foldR5), 0x00);
+    x1 = _mm_xor_si128(x1, upper);
+    // Barrett reduction
+    const __m128i poly = _mm_set_epi64x(barrettMu, barrettPoly);
+    __m128i t = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+    t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+    return static_cast<std::uint32_t>(_mm_extract_epi32(_mm_xor_si128(t, x1), 1));
+}
+#endif
+
+} // namespace
+
+// Begin Crc Implementations
+Crc::Crc(const CrcParams& params, [[maybe_unused]] bool accelerate)
+    : params{params},
+      shift{params.reflected ? 0 : 32 - params.width},
+      kernel{Kernel::Table},
+      tables{} {
+    if (params.width == 0 || params.width > 32) {
+        throw std::runtime_error("CRC width must be between 1 and 32 bits");
+    }
+    const std::uint32_t poly = params.poly & widthMask(params.width);
+    if (params.reflected) {
+        const std::uint32_t reflectedPoly = reflect(poly, params.width);
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ reflectedPoly : crc >> 1;
+            }
+            tables[0][i] = crc;
+        }
+        for (std::size_t k = 1; k < tables.size(); ++k) {
+            for (std::size_t i = 0; i < 256; ++i) {
+                const std::uint32_t previous = tables[k - 1][i];
+                tables[k][i] = (previous >> 8) ^ tables[0][previous & 0xff];
+            }
+        }
+    } else {
+        const std::uint32_t alignedPoly = poly << shift;
+        for (std::uint32_t i = 0; i < 256; ++i) {
+            std::uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x80000000) ? (crc << 1) ^ alignedPoly : crc << 1;
+            }
+            tables[0][i] = crc;
+        }
+        for (std::size_t k = 1; k < tables.size(); ++k) {
+            for (std::size_t i = 0; i < 256; ++i) {
+                const std::uint32_t previous = tables[k - 1][i];
+                tables[k][i] = (previous << 8) ^ tables[0][previous >> 24];
+            }
+        }
+    }
+
+#if VSC_CRC_X86
+    if (accelerate && params.width == 32 && params.reflected) {
+        if (poly == crc32c.poly && __builtin_cpu_supports("sse4.2")) {
+            kernel = Kernel::Sse42;
+        } else if (poly == crc32Ieee.poly && __builtin_cpu_supports("pclmul") &&
+                   __builtin_cpu_supports("sse4.1")) {
+            kernel = Kernel::Pclmul;
+        }
+    }
+#endif
+}
+
+const char* Crc::getImplementation() const {
+    switch (kernel) {
+        case Kernel::Sse42:
+            return "sse4.2";
+        case Kernel::Pclmul:
+            return "pclmul";
+        default:
+            return "slicing-by-8";
+    }
+}
+
+std::uint32_t Crc::begin() const {
+    const std::uint32_t init = params.init & widthMask(params.width);
+    return params.reflected ? reflect(init, params.width) : init << shift;
+}
+
+std::uint32_t Crc::finish(std::uint32_t state) const {
+    return ((state >> shift) ^ params.xorOut) & widthMask(params.width);
+}
+
+std::uint32_t Crc::update(std::uint32_t state, std::span<const std::uint8_t> data) const {
+    const std::uint8_t* p = data.data();
+    std::size_t size = data.size();
+#if VSC_CRC_X86
+    if (kernel == Kernel::Sse42) {
+        return crc32cSse42(state, p, size);
+    }
+    if (kernel == Kernel::Pclmul && size >= 64) {
+        const std::size_t bulk = size & ~std::size_t{15};
+        state = crc32Pclmul(state, p, bulk);
+        p += bulk;
+        size -= bulk;
+    }
+#endif
+    return updateTable(state, p, size);
+}
+
+std::uint32_t Crc::updateTable(std::uint32_t state, const std::uint8_t* data,
+                               std::size_t size) const {
+    const auto& t = tables;
+    if (params.reflected) {
+        for (; size >= 8; size -= 8, data += 8) {
+            const std::uint32_t low = load32Le(data) ^ state;
+            const std::uint32_t high = load32Le(data + 4);
+            state = t[7][low & 0xff] ^ t[6][(low >> 8) & 0xff] ^
+                    t[5][(low >> 16) & 0xff] ^ t[4][low >> 24] ^ t[3][high & 0xff] ^
+                    t[2][(high >> 8) & 0xff] ^ t[1][(high >> 16) & 0xff] ^
+                    t[0][high >> 24];
+        }
+        for (; size > 0; --size) {
+            state = (state >> 8) ^ t[0][(state ^ *data++) & 0xff];
+        }
+    } else {
+        for (; size >= 8; size -= 8, data += 8) {
+            const std::uint32_t high = load32Be(data) ^ state;
+            const std::uint32_t low = load32Be(data + 4);
+            state = t[7][high >> 24] ^ t[6][(high >> 16) & 0xff] ^
+                    t[5][(high >> 8) & 0xff] ^ t[4][high & 0xff] ^ t[3][low >> 24] ^
+                    t[2][(low >> 16) & 0xff] ^ t[1][(low >> 8) & 0xff] ^ t[0][low & 0xff];
+        }
+        for (; size > 0; --size) {
+            state = (state << 8) ^ t[0][(state >> 24) ^ *data++];
+        }
+    }
+    return state;
+}
+// End Crc Implementations
+
+} // namespace vsc
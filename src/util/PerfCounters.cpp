@@ -0,0 +1,219 @@
+/** @file
+ * Hardware performance counter implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "VSC/util/PerfCounters.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr std::array<std::uint64_t, perfEventCount> hardwareEvents = {
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+/**
+ * PERF_FORMAT_GROUP read layout with both time fields enabled
+ */
+struct GroupReading {
+    std::uint64_t count;
+    std::uint64_t timeEnabled;
+    std::uint64_t timeRunning;
+    std::uint64_t values[perfEventCount];
+};
+
+int openEvent(std::uint64_t config, int groupFd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.disabled = groupFd < 0 ? 1 : 0; // the leader starts the whole group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                       PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+} // namespace
+
+const char* perfEventName(PerfEvent event) {
+    switch (event) {
+        case PerfEvent::Instructions:
+            return "instructions";
+        case PerfEvent::Cycles:
+            return "cycles";
+        case PerfEvent::CacheMisses:
+            return "cache-misses";
+        case PerfEvent::BranchMisses:
+            return "branch-misses";
+    }
+    return "unknown";
+}
+
+// Begin PhaseCounters Implementations
+PhaseCounters::PhaseCounters(std::uint64_t sampleEvery)
+    : leader{-1},
+      opened{0},
+      sampleEvery{std::max<std::uint64_t>(sampleEvery, 1)},
+      countdown{this->sampleEvery},
+      measuredCycles{0},
+      multiplexed{false},
+      droppedSamples{0},
+      entry{},
+      entryValid{false},
+      totals{} {
+    fds.fill(-1);
+    slot.fill(-1);
+    for (std::size_t i = 0; i < perfEventCount; ++i) {
+        const int fd = openEvent(hardwareEvents[i], leader);
+        if (fd < 0) {
+            continue; // not supported or not permitted
+        }
+        if (leader < 0) {
+            leader = fd;
+        }
+        fds[i] = fd;
+        slot[i] = static_cast<int>(opened++);
+    }
+    if (leader >= 0) {
+        ::ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ::ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+PhaseCounters::~PhaseCounters() {
+    for (int fd : fds) {
+        if (fd >= 0) {
+            ::close(fd);
+        }
+    }
+}
+
+bool PhaseCounters::readGroup(PerfValues& values) {
+    GroupReading reading;
+    const ssize_t count = ::read(leader, &reading, sizeof(reading));
+    // header plus one value per opened event
+    const std::size_t expected = (3 + opened) * sizeof(std::uint64_t);
+    if (count < 0 || static_cast<std::size_t>(count) < expected) {
+        return false;
+    }
+    if (reading.timeRunning < reading.timeEnabled) {
+        multiplexed = true;
+    }
+    values.fill(0);
+    for (std::size_t i = 0; i < perfEventCount; ++i) {
+        if (slot[i] >= 0) {
+            values[i] = reading.values[slot[i]];
+        }
+    }
+    return true;
+}
+
+void PhaseCounters::leavePhase(BenchPhase phase) {
+    PerfValues exit;
+    // a difference against a failed read would wrap the unsigned totals
+    if (!entryValid || !readGroup(exit)) {
+        ++droppedSamples;
+        return;
+    }
+    PerfValues& total = totals[static_cast<std::size_t>(phase)];
+    for (std::size_t i = 0; i < perfEventCount; ++i) {
+        total[i] += exit[i] - entry[i];
+    }
+}
+
+void PhaseCounters::reset() {
+    measuredCycles = 0;
+    multiplexed = false;
+    droppedSamples = 0;
+    countdown = sampleEvery;
+    for (PerfValues& total : totals) {
+        total.fill(0);
+    }
+}
+
+PhaseCounterReport PhaseCounters::report() const {
+    PhaseCounterReport result;
+    result.measuredCycles = measuredCycles;
+    result.multiplexed = multiplexed;
+    result.droppedSamples = droppedSamples;
+    for (std::size_t i = 0; i < perfEventCount; ++i) {
+        result.available[i] = slot[i] >= 0;
+    }
+    if (measuredCycles == 0) {
+        return result;
+    }
+    for (std::size_t phase = 0; phase < benchPhaseCount; ++phase) {
+        for (std::size_t i = 0; i < perfEventCount; ++i) {
+            result.perCycle[phase][i] = static_cast<double>(totals[phase][i]) /
+                                        static_cast<double>(measuredCycles);
+        }
+    }
+    return result;
+}
+// End PhaseCounters Implementations
+
+std::string PhaseCounterReport::format() const {
+    constexpr auto instructions = static_cast<std::size_t>(PerfEvent::Instructions);
+    constexpr auto cycles = static_cast<std::size_t>(PerfEvent::Cycles);
+    constexpr auto cacheMisses = static_cast<std::size_t>(PerfEvent::CacheMisses);
+    constexpr auto branchMisses = static_cast<std::size_t>(PerfEvent::BranchMisses);
+
+    std::string out;
+    char line[160];
+    std::snprintf(line, sizeof(line), "%llu measured cycles%s\n",
+                  static_cast<unsigned long long>(measuredCycles),
+                  multiplexed ? " (counters were multiplexed)" : "");
+    out += line;
+    std::snprintf(line, sizeof(line), "%-14s %12s %12s %6s %12s %12s\n", "phase",
+                  "instr/cyc", "cpu cyc/cyc", "IPC", "cache MPKI", "branch MPKI");
+    out += line;
+
+    std::array<double, perfEventCount> sum{};
+    auto formatRow = [&](const char* name, const std::array<double, perfEventCount>& v) {
+        const double kiloInstructions = v[instructions] / 1000.0;
+        auto ratio = [](double num, double den) { return den > 0.0 ? num / den : 0.0; };
+        std::snprintf(line, sizeof(line), "%-14s %12.1f %12.1f %6.2f %12.2f %12.2f\n",
+                      name, v[instructions], v[cycles], ratio(v[instructions], v[cycles]),
+                      ratio(v[cacheMisses], kiloInstructions),
+                      ratio(v[branchMisses], kiloInstructions));
+        out += line;
+    };
+    for (std::size_t phase = 0; phase < benchPhaseCount; ++phase) {
+        formatRow(benchPhaseName(static_cast<BenchPhase>(phase)), perCycle[phase]);
+        for (std::size_t i = 0; i < perfEventCount; ++i) {
+            sum[i] += perCycle[phase][i];
+        }
+    }
+    formatRow("total", sum);
+    if (droppedSamples > 0) {
+        std::snprintf(line, sizeof(line), "%llu phase samples dropped on failed reads\n",
+                      static_cast<unsigned long long>(droppedSamples));
+        out += line;
+    }
+    for (std::size_t i = 0; i < perfEventCount; ++i) {
+        if (!available[i]) {
+            out += std::string(perfEventName(static_cast<PerfEvent>(i))) +
+                   " unavailable on this host\n";
+        }
+    }
+    return out;
+}
+
+} // namespace vsc
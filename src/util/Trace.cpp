@@ -0,0 +1,264 @@
+/** @file
+ * Span tracing implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "VSC/util/Trace.h"
+
+namespace vsc {
+
+namespace internal {
+
+std::atomic<bool> tracingEnabled{false};
+
+} // namespace internal
+
+namespace {
+
+/**
+ * Events of one thread. The owner appends under an uncontended lock; the exporter
+ * takes the same lock, so an export may run while the thread keeps recording.
+ */
+struct ThreadBuffer {
+    std::mutex lock;
+    std::vector<TraceEvent> events;
+    std::uint64_t dropped = 0;
+    std::string name;
+    int tid = 0;
+    bool retired = false; // owning thread has exited, guarded by the registry lock
+};
+
+/**
+ * Buffers of live threads and of exited threads whose events have not been cleared yet.
+ * Buffers without events are moved to the free list when their thread exits (or when
+ * their events are cleared) and handed to the next new thread, so threads that come and
+ * go do not grow the registry.
+ */
+struct TraceRegistry {
+    std::mutex lock;
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    std::vector<std::shared_ptr<ThreadBuffer>> freeBuffers;
+    std::atomic<std::size_t> maxEvents{0};
+    int nextTid = 1;
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+/**
+ * Registers the thread's buffer on first use and retires it when the thread exits.
+ */
+class BufferOwner {
+private:
+    std::shared_ptr<ThreadBuffer> buffer;
+
+public:
+    BufferOwner() {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+        if (reg.freeBuffers.empty()) {
+            buffer = std::make_shared<ThreadBuffer>();
+        } else {
+            buffer = std::move(reg.freeBuffers.back());
+            reg.freeBuffers.pop_back();
+            buffer->retired = false;
+        }
+        // a recycled buffer gets a fresh tid, so exports never merge two threads
+        buffer->tid = reg.nextTid++;
+        buffer->name = "thread " + std::to_string(buffer->tid);
+        reg.buffers.push_back(buffer);
+    }
+    ~BufferOwner() {
+        TraceRegistry& reg = registry();
+        std::lock_guard<std::mutex> guard(reg.lock);
+        buffer->retired = true;
+        bool empty;
+        {
+            std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+            empty = buffer->events.empty() && buffer->dropped == 0;
+        }
+        if (empty) {
+            // nothing left to export, recycle it right away
+            std::erase(reg.buffers, buffer);
+            reg.freeBuffers.push_back(std::move(buffer));
+        }
+    }
+
+    ThreadBuffer& get() { return *buffer; }
+
+    BufferOwner(const BufferOwner& other) = delete;
+    BufferOwner& operator=(const BufferOwner& other) = delete;
+};
+
+ThreadBuffer& localBuffer() {
+    thread_local BufferOwner owner;
+    return owner.get();
+}
+
+std::string escapeJson(const char* text) {
+    std::string out;
+    for (; *text != '\0'; ++text) {
+        const char c = *text;
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out += escaped;
+        } else {
+            out += c;
+        }
+    }
+    return out;
+}
+
+void writeEvent(std::ostream& out, const TraceEvent& event, long pid, int tid) {
+    char timing[96];
+    // Chrome traces use microseconds; keep nanosecond resolution in the fraction
+    std::snprintf(timing, sizeof(timing), "\"ts\":%.3f",
+                  static_cast<double>(event.startNs) * 1e-3);
+    out << "{\"name\":\"" << escapeJson(event.name) << "\",\"cat\":\""
+        << escapeJson(event.category) << "\",\"ph\":\"" << event.phase << "\","
+        << timing << ",\"pid\":" << pid << ",\"tid\":" << tid;
+    switch (event.phase) {
+        case 'X':
+            std::snprintf(timing, sizeof(timing), ",\"dur\":%.3f",
+                          static_cast<double>(event.durationNs) * 1e-3);
+            out << timing;
+            break;
+        case 'i':
+            out << ",\"s\":\"t\"";
+            break;
+        case 'C':
+            std::snprintf(timing, sizeof(timing), ",\"args\":{\"value\":%.17g}",
+                          event.value);
+            out << timing;
+            break;
+    }
+    out << "}";
+}
+
+} // namespace
+
+std::int64_t internal::traceClockNs() {
+    using namespace std::chrono;
+    static const steady_clock::time_point origin = steady_clock::now();
+    return duration_cast<nanoseconds>(steady_clock::now() - origin).count();
+}
+
+void internal::recordTraceEvent(const TraceEvent& event) {
+    ThreadBuffer& buffer = localBuffer();
+    const std::size_t limit = registry().maxEvents.load(std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(buffer.lock);
+    if (buffer.events.size() < limit) {
+        buffer.events.push_back(event);
+    } else {
+        ++buffer.dropped;
+    }
+}
+
+void startTracing(std::size_t maxEventsPerThread) {
+    internal::traceClockNs(); // pin the time origin before the first event
+    registry().maxEvents.store(maxEventsPerThread, std::memory_order_relaxed);
+    internal::tracingEnabled.store(true, std::memory_order_relaxed);
+}
+
+void stopTracing() {
+    internal::tracingEnabled.store(false, std::memory_order_relaxed);
+}
+
+void clearTrace() {
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (const auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        buffer->events.clear();
+        buffer->dropped = 0;
+    }
+    // buffers of exited threads only existed to keep their events for export
+    std::erase_if(reg.buffers, [&](std::shared_ptr<ThreadBuffer>& buffer) {
+        if (!buffer->retired) {
+            return false;
+        }
+        reg.freeBuffers.push_back(std::move(buffer));
+        return true;
+    });
+}
+
+void setTraceThreadName(std::string name) {
+    ThreadBuffer& buffer = localBuffer();
+    std::lock_guard<std::mutex> guard(buffer.lock);
+    buffer.name = std::move(name);
+}
+
+void traceInstant(const char* name, const char* category) {
+    if (isTracing()) {
+        internal::recordTraceEvent(
+            {name, category, internal::traceClockNs(), 0, 'i', 0.0});
+    }
+}
+
+void traceCounter(const char* name, double value) {
+    if (isTracing()) {
+        internal::recordTraceEvent(
+            {name, "counter", internal::traceClockNs(), 0, 'C', value});
+    }
+}
+
+void writeChromeTrace(const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("cannot open trace file: " + path);
+    }
+    const long pid = static_cast<long>(::getpid());
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separate = [&] {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    TraceRegistry& reg = registry();
+    std::lock_guard<std::mutex> guard(reg.lock);
+    for (const auto& buffer : reg.buffers) {
+        std::lock_guard<std::mutex> bufferGuard(buffer->lock);
+        separate();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << pid
+            << ",\"tid\":" << buffer->tid << ",\"args\":{\"name\":\""
+            << escapeJson(buffer->name.c_str()) << "\"}}";
+        for (const TraceEvent& event : buffer->events) {
+            separate();
+            writeEvent(out, event, pid, buffer->tid);
+        }
+        if (buffer->dropped > 0) {
+            separate();
+            out << "{\"name\":\"dropped events: " << buffer->dropped
+                << "\",\"ph\":\"i\",\"s\":\"t\",\"ts\":0,\"pid\":" << pid
+                << ",\"tid\":" << buffer->tid << "}";
+        }
+    }
+    out << "\n]}\n";
+    if (!out) {
+        throw std::runtime_error("failed writing trace file: " + path);
+    }
+}
+
+} // namespace vsc
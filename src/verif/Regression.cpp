@@ -0,0 +1,456 @@
+/** @file
+ * Regression runner implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+#include "VSC/util/Parallel.h"
+#include "VSC/verif/Regression.h"
+#include "VSC/verif/ResultCache.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr double historyWeight = 0.5; // weight of the newest sample in the average
+constexpr int childPollMs = 50;       // forked job exit polling period
+constexpr std::size_t reportHeaderBytes = 1 + sizeof(std::uint32_t);
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    using Seconds = std::chrono::duration<double>;
+    return Seconds(std::chrono::steady_clock::now() - start).count();
+}
+
+TestOutcome runGuarded(const RegressionJob& job) {
+    try {
+        return job.run(job.seed);
+    } catch (const std::exception& e) {
+        return {false, std::string("uncaught exception: ") + e.what()};
+    } catch (...) {
+        return {false, "uncaught non-standard exception"};
+    }
+}
+
+void writeAll(int fd, const char* data, std::size_t size) {
+    while (size > 0) {
+        const ssize_t written = ::write(fd, data, size);
+        if (written <= 0) {
+            return;
+        }
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+}
+
+bool reportComplete(const std::string& report) {
+    if (report.size() < reportHeaderBytes) {
+        return false;
+    }
+    std::uint32_t length;
+    std::memcpy(&length, report.data() + 1, sizeof(length));
+    return report.size() >= reportHeaderBytes + length;
+}
+
+std::string escapeXml(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+            case '&':
+                out += "&amp;";
+                break;
+            case '<':
+                out += "&lt;";
+                break;
+            case '>':
+                out += "&gt;";
+                break;
+            case '"':
+                out += "&quot;";
+                break;
+            case '\t':
+            case '\n':
+            case '\r':
+                // kept as references, attribute values normalize raw whitespace
+                out += "&#" + std::to_string(static_cast<int>(c)) + ";";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    // other control characters are not allowed anywhere in XML 1.0
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\x%02x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+std::string escapeJson(const std::string& text) {
+    std::string out;
+    for (char c : text) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            case '\n':
+                out += "\\n";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+ResultCacheKey cacheKey(const RegressionJob& job) {
+    return {job.name, job.seed, hashExecutable(), *job.modelHash, job.stimulusHash};
+}
+
+} // namespace
+
+// Begin RuntimeHistory Implementations
+RuntimeHistory RuntimeHistory::load(const std::string& path) {
+    RuntimeHistory history;
+    std::ifstream in(path);
+    double seconds;
+    std::string name;
+    while (in >> seconds && in.get() == '\t' && std::getline(in, name)) {
+        history.averages[name] = seconds;
+    }
+    return history;
+}
+
+void RuntimeHistory::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::trunc);
+    for (const auto& [name, seconds] : averages) {
+        out << seconds << '\t' << name << '\n';
+    }
+    if (!out) {
+        throw std::runtime_error("failed writing runtime history: " + path);
+    }
+}
+
+std::optional<double> RuntimeHistory::expected(const std::string& name) const {
+    const auto entry = averages.find(name);
+    if (entry == averages.end()) {
+        return std::nullopt;
+    }
+    return entry->second;
+}
+
+void RuntimeHistory::record(const std::string& name, double seconds) {
+    const auto [entry, inserted] = averages.try_emplace(name, seconds);
+    if (!inserted) {
+        entry->second = historyWeight * seconds + (1.0 - historyWeight) * entry->second;
+    }
+}
+// End RuntimeHistory Implementations
+
+// Begin RegressionRunner Implementations
+RegressionRunner::RegressionRunner(RegressionOptions options)
+    : options(std::move(options)) {
+}
+
+void RegressionRunner::addJob(RegressionJob job) {
+    if (!options.cacheDirectory.empty() && !job.modelHash) {
+        throw std::invalid_argument("regression job " + job.name +
+                                    " needs a model hash for the result cache");
+    }
+    jobs.push_back(std::move(job));
+}
+
+std::vector<JobResult> RegressionRunner::run() {
+    RuntimeHistory history;
+    if (!options.historyPath.empty()) {
+        history = RuntimeHistory::load(options.historyPath);
+    }
+
+    std::vector<JobResult> results(jobs.size());
+    std::optional<ResultCache> cache;
+    std::vector<std::size_t> pending; // jobs that were not answered by the cache
+    if (!options.cacheDirectory.empty()) {
+        cache.emplace(options.cacheDirectory);
+    }
+    for (std::size_t i = 0; i < jobs.size(); ++i) {
+        const RegressionJob& job = jobs[i];
+        const std::optional<double> hit =
+            cache ? cache->lookup(cacheKey(job)) : std::nullopt;
+        if (hit) {
+            results[i] = {job.name, job.seed, true, false, true, "cached pass", *hit};
+        } else {
+            pending.push_back(i);
+        }
+    }
+
+    // longest expected first; unknown tests count as the longest known one
+    double longestKnown = 0.0;
+    for (std::size_t i : pending) {
+        const double known = history.expected(jobs[i].name).value_or(0.0);
+        longestKnown = std::max(longestKnown, known);
+    }
+    std::vector<double> expected(jobs.size());
+    for (std::size_t i : pending) {
+        expected[i] = history.expected(jobs[i].name).value_or(longestKnown);
+    }
+    std::stable_sort(pending.begin(), pending.end(),
+                     [&](std::size_t lhs, std::size_t rhs) {
+                         return expected[lhs] > expected[rhs];
+                     });
+
+    auto finished = [&](std::size_t job) {
+        if (cache && results[job].passed) {
+            // a cache write failure only costs a re-run next time, keep the regression
+            try {
+                cache->store(cacheKey(jobs[job]), results[job].seconds);
+            } catch (const std::exception& e) {
+                std::fprintf(stderr, "warning: not caching %s: %s\n",
+                             jobs[job].name.c_str(), e.what());
+            }
+        }
+    };
+    if (options.isolation == Isolation::Forked) {
+        runForked(pending, results, finished);
+    } else {
+        parallelFor(pending.size(), options.workers, [&](std::size_t index, unsigned) {
+            results[pending[index]] = runJob(jobs[pending[index]]);
+            finished(pending[index]);
+        });
+    }
+
+    if (!options.historyPath.empty()) {
+        for (const JobResult& result : results) {
+            if (!result.crashed && !result.cached) {
+                history.record(result.name, result.seconds);
+            }
+        }
+        history.save(options.historyPath);
+    }
+    return results;
+}
+
+JobResult RegressionRunner::runJob(const RegressionJob& job) const {
+    const auto start = std::chrono::steady_clock::now();
+    TestOutcome outcome = runGuarded(job);
+    return {job.name,
+            job.seed,
+            outcome.passed,
+            false,
+            false,
+            std::move(outcome.message),
+            secondsSince(start)};
+}
+
+void RegressionRunner::runForked(const std::vector<std::size_t>& order,
+                                 std::vector<JobResult>& results,
+                                 const std::function<void(std::size_t)>& finished) const {
+    // Every fork happens on this thread with no worker threads running, so a child never
+    // inherits a lock held by another thread of the runner.
+    struct Child {
+        std::size_t job;
+        pid_t pid;
+        int fd; // report pipe, -1 once it reached EOF
+        std::string report;
+        std::chrono::steady_clock::time_point start;
+    };
+    const std::size_t limit =
+        options.workers == 0 ? defaultWorkerCount() : options.workers;
+    std::vector<Child> running;
+    std::size_t next = 0;
+    char buf[4096];
+
+    auto complete = [&](Child& child, int status, bool timedOut) {
+        const RegressionJob& job = jobs[child.job];
+        JobResult& result = results[child.job];
+        result = {job.name, job.seed, false, true, false, "", 0.0};
+        result.seconds = secondsSince(child.start);
+        if (timedOut) {
+            result.message = "timed out";
+        } else if (WIFSIGNALED(status)) {
+            result.message = "terminated by signal " + std::to_string(WTERMSIG(status));
+        } else if (!reportComplete(child.report)) {
+            result.message = "exited with status " + std::to_string(WEXITSTATUS(status)) +
+                             " before reporting";
+        } else {
+            result.crashed = false;
+            result.passed = child.report[0] == 1;
+            result.message = child.report.substr(reportHeaderBytes);
+        }
+        if (child.fd >= 0) {
+            ::close(child.fd);
+        }
+        finished(child.job);
+    };
+
+    while (next < order.size() || !running.empty()) {
+        while (running.size() < limit && next < order.size()) {
+            const std::size_t job = order[next++];
+            const auto start = std::chrono::steady_clock::now();
+            int fds[2];
+            if (::pipe(fds) != 0) {
+                results[job] = {jobs[job].name, jobs[job].seed, false, true, false,
+                                "pipe() failed", 0.0};
+                finished(job);
+                continue;
+            }
+            // the child would otherwise inherit pending output and print it a second time
+            std::cout.flush();
+            std::fflush(nullptr);
+            const pid_t pid = ::fork();
+            if (pid < 0) {
+                ::close(fds[0]);
+                ::close(fds[1]);
+                results[job] = {jobs[job].name, jobs[job].seed, false, true, false,
+                                "fork() failed", 0.0};
+                finished(job);
+                continue;
+            }
+            if (pid == 0) {
+                // child: report "<passed byte><u32 message length><message>" through the
+                // pipe
+                for (const Child& other : running) {
+                    if (other.fd >= 0) {
+                        ::close(other.fd);
+                    }
+                }
+                ::close(fds[0]);
+                const TestOutcome outcome = runGuarded(jobs[job]);
+                const char passed = outcome.passed ? 1 : 0;
+                const auto length = static_cast<std::uint32_t>(outcome.message.size());
+                writeAll(fds[1], &passed, 1);
+                writeAll(fds[1], reinterpret_cast<const char*>(&length), sizeof(length));
+                writeAll(fds[1], outcome.message.data(), length);
+                ::close(fds[1]);
+                // _exit() skips the stdio flush, which would lose the test's output when
+                // stdout is a file or pipe
+                std::cout.flush();
+                std::fflush(nullptr);
+                ::_exit(0);
+            }
+            ::close(fds[1]);
+            running.push_back({job, pid, fds[0], "", start});
+        }
+
+        std::vector<pollfd> polled;
+        for (const Child& child : running) {
+            if (child.fd >= 0) {
+                polled.push_back({child.fd, POLLIN, 0});
+            }
+        }
+        // children that closed their pipe are about to exit, check back soon
+        const bool exiting = polled.size() < running.size();
+        ::poll(polled.data(), polled.size(), exiting ? 1 : childPollMs);
+        for (const pollfd& entry : polled) {
+            if (entry.revents == 0) {
+                continue;
+            }
+            const auto owner = [&](const Child& c) { return c.fd == entry.fd; };
+            Child& child = *std::find_if(running.begin(), running.end(), owner);
+            const ssize_t got = ::read(child.fd, buf, sizeof(buf));
+            if (got > 0) {
+                child.report.append(buf, static_cast<std::size_t>(got));
+            } else {
+                ::close(child.fd);
+                child.fd = -1;
+            }
+        }
+
+        for (auto child = running.begin(); child != running.end();) {
+            int status = 0;
+            const bool timedOut = options.timeoutSeconds > 0.0 &&
+                                  secondsSince(child->start) > options.timeoutSeconds;
+            if (timedOut) {
+                ::kill(child->pid, SIGKILL);
+                ::waitpid(child->pid, &status, 0);
+            } else if (child->fd >= 0 || ::waitpid(child->pid, &status, WNOHANG) == 0) {
+                ++child; // still reporting or still running
+                continue;
+            }
+            complete(*child, status, timedOut);
+            child = running.erase(child);
+        }
+    }
+}
+// End RegressionRunner Implementations
+
+void writeJUnitReport(const std::vector<JobResult>& results, const std::string& suite,
+                      const std::string& path) {
+    std::size_t failures = 0;
+    std::size_t errors = 0;
+    double total = 0.0;
+    for (const JobResult& result : results) {
+        failures += !result.passed && !result.crashed;
+        errors += result.crashed;
+        total += result.seconds;
+    }
+
+    std::ofstream out(path, std::ios::trunc);
+    out << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
+    out << "<testsuite name=\"" << escapeXml(suite) << "\" tests=\"" << results.size()
+        << "\" failures=\"" << failures << "\" errors=\"" << errors << "\" time=\""
+        << total << "\">\n";
+    for (const JobResult& result : results) {
+        out << "  <testcase classname=\"" << escapeXml(suite) << "\" name=\""
+            << escapeXml(result.name) << ".seed" << result.seed << "\" time=\""
+            << result.seconds << "\"";
+        if (result.passed) {
+            out << "/>\n";
+            continue;
+        }
+        const char* tag = result.crashed ? "error" : "failure";
+        out << ">\n    <" << tag << " message=\"" << escapeXml(result.message) << "\"/>\n"
+            << "  </testcase>\n";
+    }
+    out << "</testsuite>\n";
+    if (!out) {
+        throw std::runtime_error("failed writing JUnit report: " + path);
+    }
+}
+
+void writeJsonReport(const std::vector<JobResult>& results, const std::string& path) {
+    std::ofstream out(path, std::ios::trunc);
+    out << "[\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const JobResult& result = results[i];
+        out << "  {\"name\": \"" << escapeJson(result.name) << "\", \"seed\": "
+            << result.seed << ", \"passed\": " << (result.passed ? "true" : "false")
+            << ", \"crashed\": " << (result.crashed ? "true" : "false")
+            << ", \"cached\": " << (result.cached ? "true" : "false")
+            << ", \"seconds\": " << result.seconds << ", \"message\": \""
+            << escapeJson(result.message) << "\"}" << (i + 1 < results.size() ? "," : "")
+            << "\n";
+    }
+    out << "]\n";
+    if (!out) {
+        throw std::runtime_error("failed writing JSON report: " + path);
+    }
+}
+
+} // namespace vsc
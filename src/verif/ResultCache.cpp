@@ -0,0 +1,121 @@
+/** @file
+ * Result cache implementation.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <span>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#include "VSC/util/Hash.h"
+#include "VSC/verif/ResultCache.h"
+
+namespace vsc {
+
+namespace {
+
+std::uint64_t hashString(const std::string& text) {
+    return hashBytes(std::as_bytes(std::span(text.data(), text.size())));
+}
+
+} // namespace
+
+std::uint64_t ResultCacheKey::digest() const {
+    std::uint64_t result = hashString(testName);
+    result = hashCombine(result, seed);
+    result = hashCombine(result, binaryHash);
+    result = hashCombine(result, modelHash);
+    return hashCombine(result, stimulusHash);
+}
+
+// Begin ResultCache Implementations
+ResultCache::ResultCache(std::string directory) : directory(std::move(directory)) {
+    std::filesystem::create_directories(this->directory);
+}
+
+std::string ResultCache::entryPath(const ResultCacheKey& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.pass",
+                  static_cast<unsigned long long>(key.digest()));
+    return directory + "/" + name;
+}
+
+std::optional<double> ResultCache::lookup(const ResultCacheKey& key) const {
+    std::ifstream in(entryPath(key));
+    double seconds;
+    std::string name;
+    // the stored name guards against digest collisions between tests
+    if (in >> seconds && in.get() == '\t' && std::getline(in, name) &&
+        name == key.testName) {
+        return seconds;
+    }
+    return std::nullopt;
+}
+
+void ResultCache::store(const ResultCacheKey& key, double seconds) const {
+    const std::string path = entryPath(key);
+    const std::string temp = path + ".tmp." + std::to_string(::getpid()) + "." +
+                             std::to_string(std::hash<std::thread::id>{}(
+                                 std::this_thread::get_id()));
+    try {
+        {
+            std::ofstream out(temp, std::ios::trunc);
+            out << seconds << '\t' << key.testName << '\n';
+            if (!out) {
+                throw std::runtime_error("failed writing result cache entry: " + temp);
+            }
+        }
+        std::filesystem::rename(temp, path);
+    } catch (...) {
+        std::error_code ignored;
+        std::filesystem::remove(temp, ignored);
+        throw;
+    }
+}
+// End ResultCache Implementations
+
+std::uint64_t hashFile(const std::string& path) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("cannot open file for hashing: " + path);
+    }
+    struct stat info;
+    if (::fstat(fd, &info) != 0) {
+        ::close(fd);
+        throw std::runtime_error("cannot stat file for hashing: " + path);
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    if (size == 0) {
+        ::close(fd);
+        return hashBytes({});
+    }
+    void* mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        throw std::runtime_error("cannot map file for hashing: " + path);
+    }
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    const std::uint64_t result =
+        hashBytes(std::span(static_cast<const std::byte*>(mapping), size));
+    ::munmap(mapping, size);
+    return result;
+}
+
+std::uint64_t hashExecutable() {
+    static const std::uint64_t executableHash = hashFile("/proc/self/exe");
+    return executableHash;
+}
+
+} // namespace vsc
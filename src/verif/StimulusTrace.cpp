@@ -0,0 +1,111 @@
+/** @file
+ * Stimulus trace serialization.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include "VSC/verif/StimulusTrace.h"
+
+namespace vsc {
+
+namespace {
+
+constexpr char traceMagic[8] = {'V', 'S', 'C', 'S', 'T', 'I', 'M', '1'};
+
+template <typename T> void writeLe(std::ostream& out, T value) {
+    std::uint8_t bytes[sizeof(T)];
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        bytes[i] = static_cast<std::uint8_t>(value >> (8 * i));
+    }
+    out.write(reinterpret_cast<const char*>(bytes), sizeof(T));
+}
+
+template <typename T> T readLe(std::istream& in, const std::string& path) {
+    std::uint8_t bytes[sizeof(T)];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+        throw std::runtime_error("truncated stimulus trace: " + path);
+    }
+    T value = 0;
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        value |= static_cast<T>(bytes[i]) << (8 * i);
+    }
+    return value;
+}
+
+} // namespace
+
+void StimulusTrace::append(std::uint64_t cycle, std::span<const std::uint8_t> payload) {
+    events.push_back({cycle, std::vector<std::uint8_t>(payload.begin(), payload.end())});
+}
+
+StimulusTrace StimulusTrace::subset(std::span<const std::size_t> indices) const {
+    StimulusTrace result;
+    result.events.reserve(indices.size());
+    for (std::size_t index : indices) {
+        result.events.push_back(events[index]);
+    }
+    return result;
+}
+
+std::uint64_t StimulusTrace::lastCycle() const {
+    return events.empty() ? 0 : events.back().cycle;
+}
+
+void StimulusTrace::save(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("cannot open stimulus trace for writing: " + path);
+    }
+    out.write(traceMagic, sizeof(traceMagic));
+    writeLe<std::uint64_t>(out, events.size());
+    for (const StimulusEvent& event : events) {
+        writeLe<std::uint64_t>(out, event.cycle);
+        writeLe<std::uint32_t>(out, static_cast<std::uint32_t>(event.payload.size()));
+        out.write(reinterpret_cast<const char*>(event.payload.data()),
+                  static_cast<std::streamsize>(event.payload.size()));
+    }
+    if (!out) {
+        throw std::runtime_error("failed writing stimulus trace: " + path);
+    }
+}
+
+StimulusTrace StimulusTrace::load(const std::string& path) {
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in) {
+        throw std::runtime_error("cannot open stimulus trace: " + path);
+    }
+    const std::streamoff fileSize = in.tellg();
+    in.seekg(0);
+    char magic[sizeof(traceMagic)];
+    in.read(magic, sizeof(magic));
+    if (!in || std::memcmp(magic, traceMagic, sizeof(magic)) != 0) {
+        throw std::runtime_error("not a stimulus trace: " + path);
+    }
+
+    StimulusTrace trace;
+    const auto count = readLe<std::uint64_t>(in, path);
+    for (std::uint64_t i = 0; i < count; ++i) {
+        StimulusEvent event;
+        event.cycle = readLe<std::uint64_t>(in, path);
+        const auto size = readLe<std::uint32_t>(in, path);
+        // check against the bytes left before allocating, a corrupt size field must not
+        // turn into a multi-gigabyte allocation
+        if (size > fileSize - in.tellg()) {
+            throw std::runtime_error("truncated stimulus trace: " + path);
+        }
+        event.payload.resize(size);
+        if (!in.read(reinterpret_cast<char*>(event.payload.data()),
+                     static_cast<std::streamsize>(size))) {
+            throw std::runtime_error("truncated stimulus trace: " + path);
+        }
+        trace.events.push_back(std::move(event));
+    }
+    return trace;
+}
+
+} // namespace vsc
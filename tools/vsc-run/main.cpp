@@ -0,0 +1,99 @@
+/** @file
+ * vsc-run: generic bench executable for model plugins, see ModelPlugin.h.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "VSC/plugin/PluginLoader.h"
+#include "VSC/sim/LiveStats.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [-c cycles] [-b batch] [-s name] [-q] plugin.so [args...]\n"
+                 "  -c cycles  stop after this many cycles (default: until finished)\n"
+                 "  -b batch   cycles per call into the plugin (default 65536)\n"
+                 "  -s name    publish live stats for vsc-top under this name\n"
+                 "  -q         do not print the summary\n"
+                 "  args       passed to the model, e.g. +verilator+seed+<n>\n",
+                 program);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::uint64_t maxCycles = UINT64_MAX;
+    std::uint64_t batch = 65536;
+    const char* statsName = nullptr;
+    bool quiet = false;
+    int i = 1;
+    for (; i < argc && argv[i][0] == '-'; ++i) {
+        if (std::strcmp(argv[i], "-c") == 0 && i + 1 < argc) {
+            maxCycles = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            batch = std::strtoull(argv[++i], nullptr, 0);
+        } else if (std::strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            statsName = argv[++i];
+        } else if (std::strcmp(argv[i], "-q") == 0) {
+            quiet = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (i >= argc || batch == 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    const std::string pluginPath = argv[i];
+    const std::vector<std::string> modelArgs(argv + i + 1, argv + argc);
+
+    try {
+        vsc::PluginLibrary library(pluginPath);
+        vsc::PluginModel model(library, modelArgs);
+        std::unique_ptr<vsc::LiveStatsPublisher> stats;
+        if (statsName != nullptr) {
+            stats = std::make_unique<vsc::LiveStatsPublisher>(statsName, batch);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        model.reset();
+        std::uint64_t cycles = 0;
+        while (cycles < maxCycles && !model.finished()) {
+            const std::uint64_t request = std::min(batch, maxCycles - cycles);
+            const std::uint64_t done = model.run(request);
+            cycles += done;
+            if (stats) {
+                stats->publish(cycles);
+            }
+            if (done < request) {
+                break; // finished inside the batch
+            }
+        }
+        const double seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start)
+                .count();
+
+        if (!quiet) {
+            std::fprintf(stderr, "%s: %llu cycles in %.3f s, %.0f cycles/s\n",
+                         library.getModelName(), static_cast<unsigned long long>(cycles),
+                         seconds, seconds > 0.0 ? cycles / seconds : 0.0);
+        }
+        return model.exitCode();
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s: %s\n", argv[0], e.what());
+        return 1;
+    }
+}
@@ -0,0 +1,82 @@
+/** @file
+ * vsc-top: live throughput view of every bench running on this host.
+ *
+ * SPDX-FileCopyrightText:  (C) 2024 Max Hahn
+ * SPDX-License-Identifier: BSD-3-Clause OR CERN-OHL-S-2.0
+ */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "VSC/sim/LiveStats.h"
+
+namespace {
+
+void printUsage(const char* program) {
+    std::fprintf(stderr,
+                 "usage: %s [-n seconds] [-1]\n"
+                 "  -n seconds  refresh period (default 1)\n"
+                 "  -1          print once and exit\n",
+                 program);
+}
+
+void printTable(bool clearScreen) {
+    const auto benches = vsc::readAllLiveStats();
+    if (clearScreen) {
+        std::fputs("\x1b[H\x1b[2J", stdout);
+    }
+    std::printf("%8s  %-24s %14s %12s %12s %8s %9s %7s\n", "PID", "NAME", "CYCLES",
+                "CYC/S", "TXNS", "ERRORS", "UPTIME", "STATE");
+    double totalRate = 0.0;
+    unsigned running = 0;
+    for (const auto& bench : benches) {
+        // a bench that stopped publishing is shown as stalled rather than running
+        const char* state = !bench.alive                      ? "dead"
+                            : bench.secondsSinceUpdate > 10.0 ? "stalled"
+                                                              : "run";
+        if (bench.alive) {
+            totalRate += bench.cyclesPerSecond;
+            ++running;
+        }
+        std::printf("%8lld  %-24.24s %14llu %12.0f %12llu %8llu %8.0fs %7s\n",
+                    static_cast<long long>(bench.pid), bench.name.c_str(),
+                    static_cast<unsigned long long>(bench.cycles), bench.cyclesPerSecond,
+                    static_cast<unsigned long long>(bench.transactions),
+                    static_cast<unsigned long long>(bench.errors), bench.uptimeSeconds,
+                    state);
+    }
+    std::printf("\n%u running, %.0f cycles/s total\n", running, totalRate);
+    std::fflush(stdout);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double period = 1.0;
+    bool once = false;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+            period = std::atof(argv[++i]);
+        } else if (std::strcmp(argv[i], "-1") == 0) {
+            once = true;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (period <= 0.0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (once) {
+        printTable(false);
+        return 0;
+    }
+    while (true) {
+        printTable(true);
+        std::this_thread::sleep_for(std::chrono::duration<double>(period));
+    }
+}